@@ -0,0 +1,86 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include "benchmark.hpp"
+
+#include <logsys/backend.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace{
+
+
+	std::atomic< std::size_t > executed(0);
+
+
+	/// \brief Post n records by each of count threads
+	void producers(std::size_t count, std::size_t n){
+		std::vector< std::thread > threads;
+		for(std::size_t i = 0; i < count; ++i){
+			threads.emplace_back([n]{
+					for(std::size_t j = 0; j < n; ++j){
+						logsys::detail::closure record([]{ ++executed; });
+						if(!logsys::detail::backend_post(record)) record();
+					}
+				});
+		}
+		for(auto& thread: threads) thread.join();
+		logsys::flush_backend();
+	}
+
+
+}
+
+
+int main(){
+	constexpr std::size_t n = 100000;
+
+	struct{
+		char const* name;
+		std::size_t spin_limit;
+		std::size_t yield_limit;
+		std::size_t numa_nodes;
+	} const strategies[] = {
+			{"default", logsys::backend_options().spin_limit,
+				logsys::backend_options().yield_limit, 0},
+			{"sleep", 0, 0, 0},
+			{"spin", 100000, 100, 0},
+			{"2 NUMA shards", logsys::backend_options().spin_limit,
+				logsys::backend_options().yield_limit, 2}
+		};
+
+	for(auto const& strategy: strategies){
+		logsys::backend_options options;
+		options.spin_limit = strategy.spin_limit;
+		options.yield_limit = strategy.yield_limit;
+		options.numa_shards = strategy.numa_nodes > 0;
+		options.simulated_numa_nodes = strategy.numa_nodes;
+		logsys::start_backend(options);
+
+		auto const before = logsys::backend_statistics();
+		for(std::size_t count: {1, 2, 4, 8}){
+			auto const name = std::string(strategy.name) + ", " +
+				std::to_string(n) + " posts, " + std::to_string(count) +
+				" producers";
+			logsys::benchmark::measure(name, 10, [count]{
+					producers(count, n / count);
+				});
+		}
+		auto const after = logsys::backend_statistics();
+		std::cout << strategy.name << ": "
+			<< after.wakeups - before.wakeups << " wakeups, "
+			<< after.parks - before.parks << " parks\n";
+
+		logsys::stop_backend();
+	}
+}
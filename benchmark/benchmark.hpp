@@ -0,0 +1,53 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__benchmark__benchmark__hpp_INCLUDED_
+#define _logsys__benchmark__benchmark__hpp_INCLUDED_
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+
+
+namespace logsys::benchmark{
+
+
+	/// \brief Prevent the compiler from optimizing value away
+	template < typename T >
+	inline void do_not_optimize(T const& value){
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+	/// \brief Print the average runtime of f in nanoseconds
+	template < typename F >
+	inline void measure(
+		std::string_view name,
+		std::size_t iterations,
+		F&& f
+	){
+		for(std::size_t i = 0; i < iterations / 10; ++i) f();
+
+		auto const start = std::chrono::steady_clock::now();
+		for(std::size_t i = 0; i < iterations; ++i) f();
+		auto const end = std::chrono::steady_clock::now();
+
+		auto const ns = std::chrono::duration< double, std::nano >(
+			end - start).count() / static_cast< double >(iterations);
+
+		std::cout << std::left << std::setw(50) << name << std::right
+			<< std::fixed << std::setprecision(1) << std::setw(10) << ns
+			<< " ns\n";
+	}
+
+
+}
+
+
+#endif
@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include "benchmark.hpp"
+
+#include <logsys/stdlog.hpp>
+#include <logsys/stdlogl.hpp>
+
+
+using logsys::benchmark::do_not_optimize;
+using logsys::benchmark::measure;
+
+using inline_stdlog = logsys::basic_stdlog< logsys::inline_buffer< 256 >,
+	logsys::coarse_system_clock, logsys::per_thread_id, logsys::clog_sink >;
+
+using arena_stdlog = logsys::basic_stdlog< logsys::arena_buffer,
+	std::chrono::system_clock, logsys::global_id, logsys::clog_sink >;
+
+
+int main(){
+	constexpr std::size_t n = 1000000;
+
+	measure("stdlog construct", n, []{
+			logsys::stdlog log;
+			do_not_optimize(log);
+		});
+
+	measure("stdlogl construct", n, []{
+			logsys::stdlogl log;
+			do_not_optimize(log);
+		});
+
+	measure("inline_stdlog construct", n, []{
+			inline_stdlog log;
+			do_not_optimize(log);
+		});
+
+	measure("arena_stdlog construct", n, []{
+			arena_stdlog log;
+			do_not_optimize(log);
+		});
+
+	measure("stdlog construct + text + int", n, []{
+			logsys::stdlog log;
+			log << "value " << 42;
+			do_not_optimize(log);
+		});
+
+	measure("stdlogl construct + text + int", n, []{
+			logsys::stdlogl log;
+			log << "value " << 42;
+			do_not_optimize(log);
+		});
+
+	measure("inline_stdlog construct + text + int", n, []{
+			inline_stdlog log;
+			log << "value " << 42;
+			do_not_optimize(log);
+		});
+
+	measure("arena_stdlog construct + text + int", n, []{
+			arena_stdlog log;
+			log << "value " << 42;
+			do_not_optimize(log);
+		});
+
+	measure("stdlog construct + double", n, []{
+			logsys::stdlog log;
+			log << 3.25;
+			do_not_optimize(log);
+		});
+
+	measure("stdlogl construct + double", n, []{
+			logsys::stdlogl log;
+			log << 3.25;
+			do_not_optimize(log);
+		});
+
+	std::string const part(64, 'x');
+
+	measure("stdlog 4 KiB in 64 parts", n / 10, [&part]{
+			logsys::stdlog log;
+			for(std::size_t i = 0; i < 64; ++i) log << part;
+			do_not_optimize(log);
+		});
+
+	measure("arena_stdlog 4 KiB in 64 parts", n / 10, [&part]{
+			arena_stdlog log;
+			for(std::size_t i = 0; i < 64; ++i) log << part;
+			do_not_optimize(log);
+		});
+}
@@ -0,0 +1,49 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include "benchmark.hpp"
+
+#include <logsys/detail/append.hpp>
+
+#include <sstream>
+
+
+using logsys::benchmark::do_not_optimize;
+using logsys::benchmark::measure;
+
+
+int main(){
+	constexpr std::size_t n = 1000000;
+
+	std::ostringstream os;
+	auto const reset = [&os]{ os.seekp(0); };
+
+	measure("ostream int", n, [&]{
+			reset();
+			os << 1234567;
+			do_not_optimize(os);
+		});
+
+	measure("write_number int", n, [&]{
+			reset();
+			logsys::detail::write_number(os, 1234567);
+			do_not_optimize(os);
+		});
+
+	measure("ostream double", n, [&]{
+			reset();
+			os << 3.14159265;
+			do_not_optimize(os);
+		});
+
+	measure("write_number double", n, [&]{
+			reset();
+			logsys::detail::write_number(os, 3.14159265);
+			do_not_optimize(os);
+		});
+}
@@ -0,0 +1,91 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include "benchmark.hpp"
+
+#include <logsys/stdlogb_buffered.hpp>
+#include <logsys/stdlogt.hpp>
+#include <logsys/config.hpp>
+#include <logsys/log.hpp>
+
+
+using logsys::benchmark::do_not_optimize;
+using logsys::benchmark::measure;
+
+
+namespace{
+
+
+	struct null_tag{};
+
+	/// \brief Needs the line and discards it
+	struct null_sink: logsys::sink{
+		void write(
+			logsys::record_info const&,
+			logsys::line_ptr const& line
+		)noexcept override{
+			do_not_optimize(line);
+		}
+	};
+
+
+}
+
+
+namespace logsys{
+
+
+	/// \brief Discard the line
+	template <>
+	struct sink_binding< null_tag >{
+		static void write(record_info const&, std::string const& line){
+			do_not_optimize(line);
+		}
+	};
+
+
+}
+
+
+int main(){
+	constexpr std::size_t n = 1000000;
+
+	// no sinks, only the log object is measured
+	logsys::modify_config([](logsys::configuration& c){
+			c.sinks = logsys::sink_list();
+		});
+
+	measure("stdlogb 4 insertions", n, []{
+			logsys::log([](logsys::stdlogb& log){
+					log << "value " << 42 << " of " << 100;
+				});
+		});
+
+	measure("stdlogb_buffered 4 insertions", n, []{
+			logsys::log([](logsys::stdlogb_buffered& log){
+					log << "value " << 42 << " of " << 100;
+				});
+		});
+
+	// the line is formatted and discarded
+	logsys::modify_config([](logsys::configuration& c){
+			c.sinks = logsys::sink_list({std::make_shared< null_sink >()});
+		});
+
+	measure("stdlogb 4 insertions + line", n, []{
+			logsys::log([](logsys::stdlogb& log){
+					log << "value " << 42 << " of " << 100;
+				});
+		});
+
+	measure("stdlogt 4 insertions + line", n, []{
+			logsys::log([](logsys::stdlogt< null_tag >& log){
+					log << "value " << 42 << " of " << 100;
+				});
+		});
+}
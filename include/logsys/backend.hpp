@@ -0,0 +1,297 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__backend__hpp_INCLUDED_
+#define _logsys__backend__hpp_INCLUDED_
+
+#include "detail/closure.hpp"
+#include "detail/page_buffer.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+namespace logsys{
+
+
+	/// \brief Reaction on a record that exceeds the byte budget
+	enum class overflow_policy{
+		/// \brief Wait for space, drop the record after the timeout
+		block,
+
+		/// \brief Drop the new record
+		drop_newest,
+
+		/// \brief Drop the oldest queued records of the calling thread until
+		///        the new one fits, if there are none drop the new one
+		overwrite_oldest,
+
+		/// \brief Execute the new record by the calling thread
+		synchronous
+	};
+
+	/// \brief Memory limit and ordering of the backend queue
+	///
+	/// Every producer thread owns a ring of records. A full ring is handled
+	/// like an exhausted byte budget.
+	struct backend_options{
+		/// \brief Maximal bytes of queued records, 0 for unlimited
+		///
+		/// A record is counted by detail::closure::footprint(), which
+		/// includes the line of stdlogq and the body result of
+		/// deferred_log(), but not heap memory of lambda captures. A single
+		/// record is always accepted by an empty queue.
+		std::size_t byte_budget = 0;
+
+		/// \brief Reaction if byte_budget is exhausted
+		overflow_policy policy = overflow_policy::block;
+
+		/// \brief Maximal wait time of overflow_policy::block
+		std::chrono::milliseconds block_timeout{100};
+
+		/// \brief Minimal age of a record before it is executed
+		///
+		/// Records of different threads are executed in the order of their
+		/// time stamps. A record that is younger than the window is held
+		/// back, so records of other threads that are posted a bit later
+		/// can overtake it. 0 merges only the already posted records.
+		std::chrono::microseconds reorder_window{0};
+
+		/// \brief Checks for new records by the idle backend thread before
+		///        it yields
+		///
+		/// Spinning costs CPU time, but a spinning backend thread reacts
+		/// fast and needs no wakeup by the producers.
+		std::size_t spin_limit = 1000;
+
+		/// \brief Checks for new records with a yield before it sleeps
+		///
+		/// A sleeping backend thread must be woken by the next producer,
+		/// which costs the producer a system call.
+		std::size_t yield_limit = 10;
+
+		/// \brief CPUs of the backend thread, empty for no pinning
+		///
+		/// Ignored if numa_shards is true.
+		std::vector< int > cpu_affinity;
+
+		/// \brief One backend thread per NUMA node
+		///
+		/// Every thread is pinned to the CPUs of its node and executes the
+		/// records of the producers that started on this node. A producer's
+		/// ring is allocated by the producer, so its memory is node local.
+		/// Records of different nodes are not merged by time.
+		bool numa_shards = false;
+
+		/// \brief Split the CPUs into this count of simulated NUMA nodes
+		///
+		/// 0 for the real topology from /sys/devices/system/node.
+		std::size_t simulated_numa_nodes = 0;
+
+		/// \brief Minimal count of records per producer thread
+		///
+		/// The ring memory is rounded up to whole pages, the rest is used
+		/// for additional records.
+		std::size_t ring_capacity = 512;
+
+		/// \brief Page type of the rings
+		///
+		/// A huge page ring holds about 16000 records.
+		huge_pages ring_pages = huge_pages::none;
+
+		/// \brief Touch all ring pages on creation
+		///
+		/// Use prepare_backend_thread() to create the ring at thread start.
+		bool prefault = false;
+
+		/// \brief Lock the rings in RAM by mlock()
+		///
+		/// Silently ignored if not permitted by RLIMIT_MEMLOCK.
+		bool lock_memory = false;
+	};
+
+	/// \brief Counters of the backend since program start
+	///
+	/// Lost records (dropped and overwritten ones) are also reported in-band
+	/// by a warning line before the next executed record.
+	struct backend_counters{
+		/// \brief Records accepted by the queue
+		std::size_t posted = 0;
+
+		/// \brief Records executed by the backend thread
+		std::size_t executed = 0;
+
+		/// \brief Producers that had to wait for space
+		std::size_t blocked = 0;
+
+		/// \brief Records dropped after a timeout of overflow_policy::block
+		std::size_t block_timeouts = 0;
+
+		/// \brief Records dropped by overflow_policy::drop_newest
+		std::size_t dropped_newest = 0;
+
+		/// \brief Records dropped by overflow_policy::overwrite_oldest
+		std::size_t overwritten = 0;
+
+		/// \brief Records executed by overflow_policy::synchronous
+		std::size_t synchronous = 0;
+
+		/// \brief Bytes currently queued
+		std::size_t queued_bytes = 0;
+
+		/// \brief Maximum of queued_bytes
+		///
+		/// Without byte budget the producers do not count the bytes, the
+		/// maximum is then only sampled by backend_statistics().
+		std::size_t peak_bytes = 0;
+
+		/// \brief Sleeps of the backend thread after spinning and yielding
+		std::size_t parks = 0;
+
+		/// \brief Wakeup system calls, mostly by producers
+		std::size_t wakeups = 0;
+
+		/// \brief Memory of all producer rings
+		std::size_t ring_bytes = 0;
+	};
+
+
+	/// \brief Start the backend thread
+	///
+	/// Deferred log records are executed by the backend thread while it
+	/// runs. Otherwise they are executed by the calling thread. If the
+	/// backend is running already, only the options are replaced. Ends the
+	/// poll mode.
+	[[gnu::visibility("default")]]
+	void start_backend(backend_options const& options = backend_options());
+
+	/// \brief Execute all pending records and stop the backend thread
+	///
+	/// Called automatically on program exit.
+	[[gnu::visibility("default")]]
+	void stop_backend()noexcept;
+
+	/// \brief true if the backend thread is running or in poll mode
+	[[gnu::visibility("default")]]
+	bool backend_running()noexcept;
+
+	/// \brief Wait until all records posted so far are executed
+	///
+	/// In poll mode the calling thread executes them.
+	[[gnu::visibility("default")]]
+	void flush_backend()noexcept;
+
+	/// \brief Get the counters of the backend
+	[[gnu::visibility("default")]]
+	backend_counters backend_statistics()noexcept;
+
+
+	/// \brief Create the ring of the calling thread now
+	///
+	/// Otherwise it is created by the first post of the thread. The ring
+	/// is created with the options of the last start_backend() or
+	/// start_polling().
+	[[gnu::visibility("default")]]
+	void prepare_backend_thread();
+
+	/// \brief Accept records without a backend thread
+	///
+	/// Deferred records are queued until the application executes them by
+	/// flush_some(), e.g. in the idle hook of its event loop.
+	/// backend_event_fd() becomes readable if threshold records are
+	/// queued. A running backend thread is stopped first. stop_backend()
+	/// executes the remaining records and ends the poll mode.
+	///
+	/// overflow_policy::block waits for another thread to call
+	/// flush_some(), so single threaded applications should choose another
+	/// policy.
+	[[gnu::visibility("default")]]
+	void start_polling(
+		backend_options const& options = backend_options(),
+		std::size_t threshold = 1);
+
+	/// \brief Execute up to budget queued records by the calling thread
+	///
+	/// Records younger than backend_options::reorder_window are kept.
+	///
+	/// \return Count of executed records, 0 if not in poll mode
+	[[gnu::visibility("default")]]
+	std::size_t flush_some(std::size_t budget)noexcept;
+
+	/// \brief File descriptor for poll/epoll in poll mode
+	///
+	/// Readable while at least threshold records are queued. Never read it,
+	/// flush_some() resets it. -1 before the first start_polling() or if
+	/// not supported by the platform.
+	[[gnu::visibility("default")]]
+	int backend_event_fd()noexcept;
+
+
+	namespace detail{
+
+
+		/// \brief CPUs of a Linux cpu list like "0-3,8,10-11"
+		///
+		/// Empty if list is malformed.
+		[[gnu::visibility("default")]]
+		std::vector< int > parse_cpu_list(std::string_view list);
+
+		/// \brief CPUs of the NUMA nodes listed in dir + "/online"
+		///
+		/// dir is laid out like /sys/devices/system/node. A node without
+		/// CPUs or with an unreadable cpulist has an empty list. Empty if
+		/// the online file is missing or malformed.
+		[[gnu::visibility("default")]]
+		std::vector< std::vector< int > > sysfs_numa_nodes(
+			std::string const& dir);
+
+		/// \brief CPUs of every NUMA node
+		///
+		/// Splits the CPUs into simulated nodes if simulated is not 0. A
+		/// system without NUMA information is one node.
+		[[gnu::visibility("default")]]
+		std::vector< std::vector< int > > numa_nodes(std::size_t simulated);
+
+		/// \brief Index of the node of the current CPU in nodes
+		[[gnu::visibility("default")]]
+		std::size_t current_node(
+			std::vector< std::vector< int > > const& nodes)noexcept;
+
+		/// \brief Restrict thread to cpus, nothing if cpus is empty
+		///
+		/// \return false if not possible
+		[[gnu::visibility("default")]]
+		bool pin_thread(std::thread& thread, std::vector< int > const& cpus)
+			noexcept;
+
+
+		/// \brief Pass a record to the backend thread
+		///
+		/// \return false if the caller shall execute the record, because
+		///         the backend is not running or by
+		///         overflow_policy::synchronous; record is unchanged then
+		///
+		/// Records of different threads are executed in the order of time.
+		[[gnu::visibility("default")]]
+		bool backend_post(
+			closure& record,
+			std::chrono::system_clock::time_point time =
+				std::chrono::system_clock::now());
+
+
+	}
+
+
+}
+
+
+#endif
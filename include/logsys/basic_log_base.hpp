@@ -56,17 +56,23 @@ namespace logsys{
 	struct basic_log_base{
 		/// \brief Add a line to the log
 		template < typename LogF >
-		void log(LogF&& log_f)const noexcept{
-			detail::log(
+		void log(
+			LogF&& log_f,
+			source_location const& location = source_location::current()
+		)const noexcept{
+			detail::log(location,
 				manipulate_fn_forward< Derived >(
 					static_cast< Derived const& >(*this)), log_f);
 		}
 
 		/// \brief Add a line to the log with linked code block
 		template < typename LogF, typename Body >
-		decltype(auto) log(LogF&& log_f, Body&& body)const
-		noexcept(detail::is_body_nothrow_v< Body >){
-			return detail::log(
+		decltype(auto) log(
+			LogF&& log_f,
+			Body&& body,
+			source_location const& location = source_location::current()
+		)const noexcept(detail::is_body_nothrow_v< Body >){
+			return detail::log(location,
 				manipulate_fn_forward< Derived >(
 					static_cast< Derived const& >(*this)), log_f, body);
 		}
@@ -74,8 +80,12 @@ namespace logsys{
 		/// \brief Add a line to the log with linked code block and catch all
 		///        exceptions
 		template < typename LogF, typename Body >
-		auto exception_catching_log(LogF&& log_f, Body&& body)const noexcept{
-			return detail::exception_catching_log(
+		auto exception_catching_log(
+			LogF&& log_f,
+			Body&& body,
+			source_location const& location = source_location::current()
+		)const noexcept{
+			return detail::exception_catching_log(location,
 				manipulate_fn_forward< Derived >(
 					static_cast< Derived const& >(*this)), log_f, body);
 		}
@@ -0,0 +1,531 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__call_site__hpp_INCLUDED_
+#define _logsys__call_site__hpp_INCLUDED_
+
+#include "level.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+
+namespace logsys{
+
+
+	/// \brief Position of a log call in the source code
+	struct source_location{
+		/// \brief Get the location of the caller
+		///
+		/// Use it as default argument to get the location of the caller of
+		/// your function.
+		static constexpr source_location current(
+#if defined(__GNUC__) || defined(__clang__)
+			char const* file = __builtin_FILE(),
+			unsigned line = __builtin_LINE(),
+			char const* function = __builtin_FUNCTION()
+#else
+			char const* file = "",
+			unsigned line = 0,
+			char const* function = ""
+#endif
+		)noexcept{
+			return source_location{file, line, function};
+		}
+
+		/// \brief Name of the source file
+		char const* file;
+
+		/// \brief Line in the source file
+		unsigned line;
+
+		/// \brief Name of the calling function
+		char const* function;
+	};
+
+
+	namespace detail{
+
+
+		/// \brief a + b for non-negative values, limited to the maximum
+		constexpr std::int64_t saturating_add(std::int64_t a, std::int64_t b)
+		noexcept{
+			constexpr auto max = std::numeric_limits< std::int64_t >::max();
+			return a > max - b ? max : a + b;
+		}
+
+		/// \brief a * b for non-negative values, limited to the maximum
+		constexpr std::int64_t saturating_multiply(
+			std::int64_t a,
+			std::uint32_t b
+		)noexcept{
+			constexpr auto max = std::numeric_limits< std::int64_t >::max();
+			return b != 0 && a > max / b ? max : a * b;
+		}
+
+
+		/// \brief Counters of one call site, written by one thread only
+		///
+		/// So no cache line is written by more than one thread. The
+		/// counters of an ended thread are reused with their counts by the
+		/// next thread that logs at the site.
+		struct alignas(64) site_counters{
+			/// \brief Count a log call
+			void count_call()noexcept{
+				add(calls, 1);
+			}
+
+			/// \brief Count a failed log call
+			void count_failure()noexcept{
+				add(failures, 1);
+			}
+
+			/// \brief Add the runtime of a body function
+			template < typename Rep, typename Period >
+			void add_time(std::chrono::duration< Rep, Period > time)noexcept{
+				auto const ns = std::chrono::duration_cast<
+					std::chrono::nanoseconds >(time).count();
+				if(ns > 0) add(total_time, static_cast< std::uint64_t >(ns));
+			}
+
+			/// \brief Add value by the owning thread
+			static void add(
+				std::atomic< std::uint64_t >& counter,
+				std::uint64_t value
+			)noexcept{
+				counter.store(counter.load(std::memory_order_relaxed) + value,
+					std::memory_order_relaxed);
+			}
+
+
+			/// \brief Number of logged calls
+			std::atomic< std::uint64_t > calls{0};
+
+			/// \brief Number of failed log calls
+			std::atomic< std::uint64_t > failures{0};
+
+			/// \brief Sum of body runtime in nanoseconds
+			std::atomic< std::uint64_t > total_time{0};
+
+			/// \brief true while a thread owns the counters
+			std::atomic< bool > used{false};
+
+			/// \brief Next counters of the site
+			site_counters* next = nullptr;
+
+			/// \brief Pointer of the owning thread to the counters
+			site_counters** owner = nullptr;
+
+			/// \brief Next counters owned by the same thread
+			site_counters* owned_next = nullptr;
+		};
+
+
+		/// \brief Counters owned by the calling thread
+		inline thread_local site_counters* owned_counters = nullptr;
+
+		/// \brief true after the calling thread released its counters
+		inline thread_local bool counters_released = false;
+
+		/// \brief Releases the counters of the calling thread on thread
+		///        exit
+		struct counters_release{
+			~counters_release(){
+				counters_released = true;
+				for(auto i = owned_counters; i != nullptr;){
+					auto const next = i->owned_next;
+					*i->owner = nullptr;
+					i->used.store(false, std::memory_order_release);
+					i = next;
+				}
+				owned_counters = nullptr;
+			}
+		};
+
+		/// \brief Let counters be released on exit of the calling thread
+		///
+		/// Counters acquired after the release, e.g. by a log call in a
+		/// static destructor, are never released.
+		inline void own_counters(site_counters*& slot)noexcept{
+			if(counters_released) return;
+			thread_local counters_release release;
+			(void)release;
+			slot->owner = &slot;
+			slot->owned_next = owned_counters;
+			owned_counters = slot;
+		}
+
+
+	}
+
+
+	/// \brief Static descriptor of one log call site
+	///
+	/// There is one instance for every LogF type, which makes it one per
+	/// lambda in the source code. (A named lambda or a function pointer used
+	/// at different places shares the descriptor, the location is the one of
+	/// the first call.)
+	class call_site{
+	public:
+		/// \brief Create and register the descriptor
+		explicit call_site(source_location const& location)noexcept;
+
+		call_site(call_site const&) = delete;
+		call_site& operator=(call_site const&) = delete;
+
+
+		/// \brief Location of the first call
+		source_location const& location()const noexcept{
+			return location_;
+		}
+
+
+		/// \brief true if the site logs
+		bool enabled()const noexcept{
+			return enabled_.load(std::memory_order_relaxed);
+		}
+
+		/// \brief Enable or disable logging at this site
+		///
+		/// A disabled site still executes its body, but neither constructs
+		/// the log object nor calls the log function.
+		void enable(bool enabled)noexcept{
+			enabled_.store(enabled, std::memory_order_relaxed);
+		}
+
+
+		/// \brief Level that is set on the log object before the log
+		///        function is called
+		///
+		/// Empty if no level is set, the log object keeps its own level
+		/// then.
+		std::optional< logsys::level > level()const noexcept{
+			return level_.load(std::memory_order_relaxed);
+		}
+
+		/// \brief Set the level of the log objects of this site
+		void set_level(logsys::level level)noexcept{
+			level_.store(level, std::memory_order_relaxed);
+		}
+
+		/// \brief Let the log objects of this site keep their own level
+		void reset_level()noexcept{
+			level_.store(std::nullopt, std::memory_order_relaxed);
+		}
+
+
+		/// \brief Log only every n-th call per thread
+		///
+		/// 0 and 1 log every call.
+		void set_sampling(std::uint32_t n)noexcept{
+			sampling_.store(n, std::memory_order_relaxed);
+		}
+
+		/// \brief Get the sampling rate
+		std::uint32_t sampling()const noexcept{
+			return sampling_.load(std::memory_order_relaxed);
+		}
+
+		/// \brief Log at most per_second calls per second, with bursts of up
+		///        to burst calls
+		///
+		/// A per_second of 0 disables the limit. Calls over the limit are
+		/// suppressed, the next logged call is preceded by a line that
+		/// reports their number. The interval between two calls saturates
+		/// at about 292 years, so tiny rates log only the first call.
+		/// Starts with a full bucket.
+		void set_rate_limit(double per_second, std::uint32_t burst = 1)
+		noexcept{
+			constexpr auto max = std::numeric_limits< std::int64_t >::max();
+			std::int64_t interval = 0;
+			if(per_second > 0){
+				auto const ns = 1e9 / per_second;
+				interval = ns < static_cast< double >(max)
+					? static_cast< std::int64_t >(ns) : max;
+			}
+
+			limit_interval_.store(interval, std::memory_order_relaxed);
+			limit_burst_.store(burst == 0 ? 1 : burst,
+				std::memory_order_relaxed);
+			tat_.store(0, std::memory_order_relaxed);
+		}
+
+		/// \brief Enable the site, unset the level and reset sampling and
+		///        rate limit to their defaults
+		void restore_defaults()noexcept{
+			enable(true);
+			reset_level();
+			set_sampling(0);
+			set_rate_limit(0);
+		}
+
+		/// \brief Number of calls suppressed by sampling or rate limit
+		std::uint64_t suppressed()const noexcept{
+			return suppressed_.load(std::memory_order_relaxed);
+		}
+
+		/// \brief Decide by sampling and rate limit whether a call is logged
+		///
+		/// thread_counter() must return a reference to the sampling counter
+		/// of the calling thread for this site, it is only called if
+		/// sampling is active. Lock-free, the rate limit is a GCRA token
+		/// bucket on a single atomic.
+		template < typename ThreadCounterF >
+		bool admit(ThreadCounterF&& thread_counter)noexcept{
+			auto const n = sampling();
+			if(n > 1 && thread_counter()++ % n != 0){
+				suppress();
+				return false;
+			}
+
+			auto const interval =
+				limit_interval_.load(std::memory_order_relaxed);
+			if(interval == 0) return true;
+
+			// tolerance >= interval, since burst >= 1
+			auto const tolerance = detail::saturating_multiply(interval,
+				limit_burst_.load(std::memory_order_relaxed));
+			auto const now = std::chrono::duration_cast<
+				std::chrono::nanoseconds >(
+					std::chrono::steady_clock::now().time_since_epoch()
+				).count();
+
+			auto tat = tat_.load(std::memory_order_relaxed);
+			for(;;){
+				auto const begin = tat > now ? tat : now;
+				if(begin - now > tolerance - interval){
+					suppress();
+					return false;
+				}
+
+				if(tat_.compare_exchange_weak(tat,
+					detail::saturating_add(begin, interval),
+					std::memory_order_relaxed)
+				){
+					return true;
+				}
+			}
+		}
+
+		/// \brief Get and reset the number of suppressed calls since the
+		///        last call
+		std::uint64_t take_pending_suppressed()noexcept{
+			if(pending_suppressed_.load(std::memory_order_relaxed) == 0){
+				return 0;
+			}
+
+			return pending_suppressed_.exchange(0, std::memory_order_relaxed);
+		}
+
+
+		/// \brief Number of logged calls
+		std::uint64_t calls()const noexcept{
+			return sum(&detail::site_counters::calls);
+		}
+
+		/// \brief Number of log calls with an exception in body or log
+		///        function
+		std::uint64_t failures()const noexcept{
+			return sum(&detail::site_counters::failures);
+		}
+
+		/// \brief Sum of the runtime of all body functions
+		std::chrono::nanoseconds total_time()const noexcept{
+			return std::chrono::nanoseconds(
+				sum(&detail::site_counters::total_time));
+		}
+
+
+		/// \brief Set slot to unused counters for the calling thread
+		///
+		/// Counters of an ended thread are reused, otherwise new ones are
+		/// allocated. If that fails, the counters are shared with another
+		/// thread and counts may be lost.
+		void acquire_counters(detail::site_counters*& slot)noexcept{
+			for(auto i = counters_.load(std::memory_order_acquire);
+				i != nullptr; i = i->next
+			){
+				if(!i->used.load(std::memory_order_relaxed) &&
+					!i->used.exchange(true, std::memory_order_acquire)
+				){
+					slot = i;
+					detail::own_counters(slot);
+					return;
+				}
+			}
+
+			auto const counters = new(std::nothrow) detail::site_counters;
+			if(counters == nullptr){
+				slot = &first_counters_;
+				return;
+			}
+
+			counters->used.store(true, std::memory_order_relaxed);
+			counters->next = counters_.load(std::memory_order_relaxed);
+			while(!counters_.compare_exchange_weak(counters->next, counters,
+				std::memory_order_release, std::memory_order_relaxed));
+			slot = counters;
+			detail::own_counters(slot);
+		}
+
+
+		/// \brief Next registered call site
+		call_site* next()const noexcept{
+			return next_;
+		}
+
+
+	private:
+		/// \brief Count a suppressed call
+		void suppress()noexcept{
+			suppressed_.fetch_add(1, std::memory_order_relaxed);
+			pending_suppressed_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/// \brief Sum of a counter over all threads
+		std::uint64_t sum(
+			std::atomic< std::uint64_t > detail::site_counters::* counter
+		)const noexcept{
+			std::uint64_t result = 0;
+			for(auto i = counters_.load(std::memory_order_acquire);
+				i != nullptr; i = i->next
+			){
+				result += (i->*counter).load(std::memory_order_relaxed);
+			}
+			return result;
+		}
+
+
+		/// \brief Location of the first call
+		source_location const location_;
+
+		/// \brief true if the site logs
+		std::atomic< bool > enabled_{true};
+
+		/// \brief Level that is set on the log object, empty if none
+		std::atomic< std::optional< logsys::level > > level_{};
+
+		/// \brief Log every n-th call per thread
+		std::atomic< std::uint32_t > sampling_{0};
+
+		/// \brief Rate limit burst size
+		std::atomic< std::uint32_t > limit_burst_{1};
+
+		/// \brief Nanoseconds between two calls by rate limit, 0 is unlimited
+		std::atomic< std::int64_t > limit_interval_{0};
+
+		/// \brief Theoretical arrival time of the next call in nanoseconds
+		std::atomic< std::int64_t > tat_{0};
+
+		/// \brief Number of suppressed calls
+		std::atomic< std::uint64_t > suppressed_{0};
+
+		/// \brief Number of suppressed calls since the last logged call
+		std::atomic< std::uint64_t > pending_suppressed_{0};
+
+		/// \brief Counters of the first thread, never freed
+		detail::site_counters first_counters_;
+
+		/// \brief Counters of all threads, newest first
+		std::atomic< detail::site_counters* > counters_{&first_counters_};
+
+		/// \brief Next registered call site
+		call_site* next_ = nullptr;
+	};
+
+	static_assert(std::is_trivially_destructible_v< call_site >,
+		"call sites are used during static destruction");
+
+
+	namespace detail{
+
+
+		/// \brief Most recently registered call site
+		inline std::atomic< call_site* > call_site_list{nullptr};
+
+		/// \brief Called with every new call site after its registration
+		///
+		/// Set by the control functions to apply remembered commands.
+		inline std::atomic< void(*)(call_site&)noexcept >
+			call_site_hook{nullptr};
+
+
+		/// \brief Get the descriptor of the call site of LogF
+		///
+		/// The descriptor is created and registered on first use.
+		template < typename LogF >
+		call_site& call_site_of(source_location const& location)noexcept{
+			static call_site site(location);
+			return site;
+		}
+
+		/// \brief Counters of the call site of LogF for the calling thread
+		template < typename LogF >
+		site_counters& counters_of(call_site& site)noexcept{
+			thread_local site_counters* counters = nullptr;
+			if(counters == nullptr) site.acquire_counters(counters);
+			return *counters;
+		}
+
+		/// \brief Sampling counter of the call site of LogF for the calling
+		///        thread
+		template < typename LogF >
+		std::uint32_t& sampling_counter_of()noexcept{
+			thread_local std::uint32_t counter = 0;
+			return counter;
+		}
+
+
+	}
+
+
+	inline call_site::call_site(source_location const& location)noexcept
+		: location_(location)
+		, next_(detail::call_site_list.load(std::memory_order_relaxed))
+	{
+		while(!detail::call_site_list.compare_exchange_weak(next_, this));
+
+		auto const hook = detail::call_site_hook.load();
+		if(hook != nullptr){
+			hook(*this);
+		}
+	}
+
+
+	/// \brief Call f(call_site&) for every call site registered so far
+	template < typename F >
+	void for_each_call_site(F&& f){
+		for(
+			auto site = detail::call_site_list.load(std::memory_order_acquire);
+			site != nullptr;
+			site = site->next()
+		){
+			f(*site);
+		}
+	}
+
+	/// \brief Get all call sites registered so far
+	inline std::vector< call_site* > call_sites(){
+		std::vector< call_site* > result;
+		for_each_call_site([&result](call_site& site){
+				result.push_back(&site);
+			});
+		return result;
+	}
+
+
+}
+
+
+#endif
@@ -0,0 +1,138 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__coalesce__hpp_INCLUDED_
+#define _logsys__coalesce__hpp_INCLUDED_
+
+#include "record_info.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+
+
+namespace logsys{
+
+
+	/// \brief Summary of suppressed duplicates of a message
+	struct repeat_summary{
+		/// \brief Meta data of the last duplicate
+		record_info last;
+
+		/// \brief Number of suppressed duplicates
+		std::size_t count;
+
+		/// \brief Start time of the first duplicate
+		std::chrono::system_clock::time_point first_start;
+
+		/// \brief Shortest body runtime of the duplicates
+		std::chrono::system_clock::duration min_duration;
+
+		/// \brief Longest body runtime of the duplicates
+		std::chrono::system_clock::duration max_duration;
+
+
+		/// \brief Format the summary as log line
+		[[gnu::visibility("default")]]
+		std::string make_log_line()const;
+	};
+
+
+	/// \brief Detects consecutive duplicates of messages
+	///
+	/// Two records are duplicates if message text, body state, level and
+	/// the exceptions are equal. Exceptions are equal if they are the same
+	/// object or have the same type and what(). ID and time are ignored.
+	class [[gnu::visibility("default")]] coalescer{
+	public:
+		/// \brief Result of add()
+		struct result{
+			/// \brief true if the record is a duplicate and must not be
+			///        output
+			bool duplicate;
+
+			/// \brief Summary of the duplicates of the previous message,
+			///        output it before the new record
+			std::optional< repeat_summary > summary;
+		};
+
+
+		/// \brief Add a record
+		result add(
+			record_info const& info,
+			std::string_view message,
+			std::exception_ptr const& body_exception = nullptr,
+			std::exception_ptr const& log_exception = nullptr);
+
+		/// \brief Get and reset the summary of pending duplicates
+		std::optional< repeat_summary > flush()noexcept;
+
+
+	private:
+		/// \brief true if there is a previous message
+		bool active_ = false;
+
+		/// \brief Hash of the previous message
+		std::size_t hash_ = 0;
+
+		/// \brief Meta data of the previous message
+		record_info info_{};
+
+		/// \brief Text of the previous message
+		std::string message_;
+
+		/// \brief Body exception of the previous message
+		std::exception_ptr body_exception_;
+
+		/// \brief Log exception of the previous message
+		std::exception_ptr log_exception_;
+
+		/// \brief Type and what() of body_exception_
+		std::string body_exception_text_;
+
+		/// \brief Type and what() of log_exception_
+		std::string log_exception_text_;
+
+		/// \brief Summary of the duplicates of the previous message
+		repeat_summary summary_{};
+	};
+
+
+	/// \brief Output the summary of pending duplicates of the calling thread
+	///
+	/// Done automatically when a different message is logged or the thread
+	/// exits. Only relevant if coalescing is enabled in the configuration.
+	[[gnu::visibility("default")]]
+	void flush_coalesced()noexcept;
+
+
+	namespace detail{
+
+
+		/// \brief Coalesce the record in the calling thread
+		///
+		/// Outputs the summary of the previous message if necessary.
+		///
+		/// \return true if the record is a duplicate and must not be output
+		[[gnu::visibility("default")]]
+		bool coalesce(
+			record_info const& info,
+			std::string_view message,
+			std::exception_ptr const& body_exception,
+			std::exception_ptr const& log_exception);
+
+
+	}
+
+
+}
+
+
+#endif
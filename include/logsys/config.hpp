@@ -0,0 +1,144 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__config__hpp_INCLUDED_
+#define _logsys__config__hpp_INCLUDED_
+
+#include "sink.hpp"
+#include "level.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+
+namespace logsys{
+
+
+	class stdlog_base;
+
+
+	/// \brief Log object creator for stdlogb
+	using stdlogb_factory = std::unique_ptr< stdlog_base >(*)()noexcept;
+
+
+	/// \brief Runtime configuration of the dynamic log
+	///
+	/// A published configuration is immutable. To change it, copy it, modify
+	/// the copy and publish it by set_config() or use modify_config().
+	struct configuration{
+		/// \brief Log object creator for stdlogb
+		///
+		/// If nullptr, stdlogb_factory_object is used.
+		stdlogb_factory factory = nullptr;
+
+		/// \brief Destinations of stdlogd records
+		sink_list sinks;
+
+		/// \brief Records with a lower level are not output
+		level threshold = level::trace;
+
+		/// \brief Records with a body that was faster are not output
+		std::chrono::system_clock::duration duration_threshold{0};
+
+		/// \brief Suppress consecutive duplicates per thread
+		///
+		/// The duplicates are reported by one summary line. (See
+		/// coalesce.hpp.)
+		bool coalesce = false;
+
+
+		/// \brief true if a record passes the thresholds
+		bool accept(record_info const& info)const noexcept{
+			return info.level >= threshold && (
+				info.body == body_state::none ||
+				info.failed() ||
+				info.duration() >= duration_threshold);
+		}
+	};
+
+
+	/// \brief Read access to the current configuration
+	///
+	/// Keeps the configuration alive, even if a new one is published
+	/// meanwhile. The calling thread marks itself as reader in a slot of
+	/// its own, so no shared cache line is written. Readers of one thread
+	/// can be nested. Hold it for the duration of a log call only, because
+	/// no replaced configuration is destroyed while it lives.
+	class [[gnu::visibility("default")]] config_ptr{
+	public:
+		/// \brief Enter the read section and load the configuration
+		config_ptr()noexcept;
+
+		config_ptr(config_ptr const&) = delete;
+
+		config_ptr& operator=(config_ptr const&) = delete;
+
+		/// \brief Leave the read section
+		~config_ptr();
+
+
+		/// \brief The configuration
+		configuration const& operator*()const noexcept{
+			return *config_;
+		}
+
+		/// \brief The configuration
+		configuration const* operator->()const noexcept{
+			return config_;
+		}
+
+	private:
+		/// \brief The configuration
+		configuration const* config_;
+	};
+
+
+	/// \brief Get the current configuration
+	///
+	/// See config_ptr.
+	inline config_ptr config()noexcept{
+		return config_ptr();
+	}
+
+	/// \brief Publish a new configuration
+	///
+	/// Threads that are logging continue with the old configuration until
+	/// their next call of config(). The old configuration, and with it every
+	/// sink that is no longer in use, is destroyed when the last of them
+	/// finished its call. (By the call itself, if no thread reads it, else
+	/// by the last reader or by a later publication.)
+	[[gnu::visibility("default")]]
+	void set_config(configuration new_config);
+
+	/// \brief Publish f(copy_of_current_config)
+	///
+	/// Concurrent calls of modify_config() are serialized, so no
+	/// modification is lost.
+	[[gnu::visibility("default")]]
+	void modify_config(std::function< void(configuration&) > const& f);
+
+
+	namespace detail{
+
+
+		/// \brief configuration::factory of the current configuration
+		///
+		/// Published separately, so stdlogb reads it without a read
+		/// section.
+		[[gnu::visibility("default")]]
+		stdlogb_factory config_factory()noexcept;
+
+
+	}
+
+
+}
+
+
+#endif
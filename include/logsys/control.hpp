@@ -0,0 +1,81 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__control__hpp_INCLUDED_
+#define _logsys__control__hpp_INCLUDED_
+
+#include "call_site.hpp"
+
+#include <string>
+#include <string_view>
+
+
+namespace logsys{
+
+
+	/// \brief Change call sites at runtime
+	///
+	/// A command has the form `[file <glob>] [func <glob>] [line <n>[-<m>]]
+	/// <action>...`, e.g. `file net/*.cpp func connect* -p`. A file glob
+	/// matches the full path or the file name. Available actions are `+p`
+	/// (enable), `-p` (disable), `level=<trace|debug|info|warning|error>`,
+	/// `sample=<n>` (log every n-th call) and `ratelimit=<n>[/<burst>]`
+	/// (log at most n calls per second).
+	///
+	/// The command is applied to all matching call sites registered so far
+	/// and remembered for call sites registered later. A later command
+	/// with the same selection replaces the actions it sets again.
+	///
+	/// \return Number of matching call sites registered so far
+	///
+	/// \throw std::invalid_argument if the command is ill-formed
+	[[gnu::visibility("default")]]
+	std::size_t control(std::string_view command);
+
+	/// \brief Apply every line of a control file as command, now and on
+	///        every change of the file
+	///
+	/// Empty lines and lines starting with `#` are ignored. On a change the
+	/// actions of the previous file content are reset to their defaults,
+	/// then the commands of the new file content and afterwards all
+	/// commands of control() are applied to the matching call sites. So
+	/// removed lines are reverted and control() takes precedence over the
+	/// file. Call sites that no file command matches keep the state set by
+	/// the call_site API. Ill-formed lines are reported to std::cerr and
+	/// skipped. Changes are detected via inotify on Linux, other systems
+	/// read the file only once.
+	///
+	/// Only one file can be watched, a second call replaces the first.
+	///
+	/// \throw std::runtime_error if the file can not be read
+	[[gnu::visibility("default")]]
+	void watch_control_file(std::string const& filename);
+
+	/// \brief Stop watching the control file
+	///
+	/// The actions of the file are reverted as if it were empty.
+	[[gnu::visibility("default")]]
+	void unwatch_control_file();
+
+
+	namespace detail{
+
+
+		/// \brief true if text matches the glob pattern with `*` and `?`
+		[[gnu::visibility("default")]]
+		bool glob_match(std::string_view pattern, std::string_view text)
+			noexcept;
+
+
+	}
+
+
+}
+
+
+#endif
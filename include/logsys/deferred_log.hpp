@@ -0,0 +1,346 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__deferred_log__hpp_INCLUDED_
+#define _logsys__deferred_log__hpp_INCLUDED_
+
+#include "log.hpp"
+#include "stdlog.hpp"
+#include "backend.hpp"
+
+#include <type_traits>
+#include <utility>
+
+
+namespace logsys{
+
+
+	namespace detail{
+
+
+		/// \brief Body result as seen by a deferred log function
+		template < typename LogF, typename BodyRT >
+		using deferred_value_t = std::conditional_t<
+			is_simple_log_f< LogF, stdlog >, bool, optional< BodyRT > >;
+
+		/// \brief true if log_f can be executed on the backend thread
+		///
+		/// Requires stdlog as Log type, a log function that can be moved or
+		/// copied into the record and, if the log function takes the body
+		/// result, a body result that can be copied by value.
+		template < typename LogF, typename BodyRT >
+		constexpr bool is_deferrable_v = []{
+				using log_f_type = std::decay_t< LogF >;
+				using log_type = extract_log_t< LogF, BodyRT >;
+				if constexpr(!std::is_same_v< log_type, stdlog >){
+					return false;
+				}else if constexpr(!std::is_constructible_v<
+					log_f_type, LogF&& >
+				){
+					return false;
+				}else if constexpr(
+					is_simple_log_f< log_f_type, stdlog > ||
+					std::is_same_v< BodyRT, nobody_t > ||
+					std::is_void_v< BodyRT >
+				){
+					return true;
+				}else{
+					return std::is_object_v< BodyRT > &&
+						std::is_copy_constructible_v< BodyRT >;
+				}
+			}();
+
+
+		/// \brief Closure of a log function, executed on the backend thread
+		template < typename LogF, typename Value >
+		struct deferred_record{
+			/// \brief Execute log_f against a restored stdlog and output it
+			void operator()(){
+				stdlog log(info, body_exception);
+
+				try{
+					if constexpr(is_simple_log_f< LogF, stdlog >){
+						std::invoke(log_f, log);
+					}else{
+						std::invoke(log_f, log, std::as_const(value));
+					}
+				}catch(...){
+					// a failed body is counted already
+					if(!body_exception){
+						thread_counters< LogF >(*site).count_failure();
+					}
+					log.set_log_exception(std::current_exception());
+				}
+
+				log.exec();
+			}
+
+			/// \brief Heap bytes of the log function and the body result
+			///
+			/// Captures of a lambda are not included, a function object
+			/// with a footprint() member can report them. (See
+			/// owned_bytes().)
+			std::size_t footprint()const noexcept{
+				if constexpr(std::is_same_v< Value, bool >){
+					return owned_bytes(log_f);
+				}else{
+					return owned_bytes(log_f) + owned_bytes(value);
+				}
+			}
+
+			/// \brief Call site of the log call
+			call_site* site;
+
+			/// \brief The users log function with its captures
+			LogF log_f;
+
+			/// \brief Meta data of the record
+			record_info info;
+
+			/// \brief Exception throw in body function
+			std::exception_ptr body_exception;
+
+			/// \brief Snapshot of the body result
+			Value value;
+		};
+
+
+		/// \brief Closure of a formatted line, written by Sink on the backend
+		///        thread
+		template < typename Sink >
+		struct deferred_line{
+			/// \brief Output the line
+			void operator()(){
+				Sink::write(info, line);
+			}
+
+			/// \brief The line is counted by the byte budget
+			std::size_t footprint()const noexcept{
+				return owned_bytes(line);
+			}
+
+			/// \brief Meta data of the record
+			record_info info;
+
+			/// \brief The formatted line
+			std::string line;
+		};
+
+
+		/// \brief Create record meta data at log call time
+		inline record_info deferred_info(call_site& site)noexcept{
+			auto const now = std::chrono::system_clock::now();
+			return record_info{global_id::next(), now, now,
+				body_state::none, false,
+				site.level().value_or(logsys::level::info)};
+		}
+
+		/// \brief Hand the record to the backend or execute it now
+		template < typename LogF, typename Value >
+		inline void post_deferred(
+			call_site& site,
+			LogF&& log_f,
+			record_info const& info,
+			std::exception_ptr body_exception,
+			Value&& value
+		)noexcept{
+			using record_type = deferred_record<
+				std::decay_t< LogF >, std::decay_t< Value > >;
+
+			try{
+				closure record(record_type{&site, static_cast< LogF&& >(log_f),
+					info, body_exception, static_cast< Value&& >(value)});
+				if(!backend_post(record, info.end)){
+					record();
+				}
+			}catch(std::exception const& e){
+				std::cerr << "deferred log record lost by exception: "
+					<< e.what() << std::endl;
+			}catch(...){
+				std::cerr << "deferred log record lost by unknown exception"
+					<< std::endl;
+			}
+		}
+
+
+	}
+
+
+	/// \brief Sink policy of basic_stdlog: pass the line to the backend
+	///
+	/// The message is formatted by the calling thread, Sink::write() is
+	/// executed by the backend thread or in poll mode by flush_some(). If
+	/// the backend is not running, Sink::write() is called immediately.
+	template < typename Sink >
+	struct deferred_sink{
+		/// \brief Post a record that outputs line by Sink
+		static void write(record_info const& info, std::string const& line){
+			detail::closure record(detail::deferred_line< Sink >{info, line});
+			if(!detail::backend_post(record, info.end)){
+				record();
+			}
+		}
+	};
+
+	/// \brief Like stdlog, but the output is done by the backend
+	///
+	/// Together with start_polling() the application decides when the I/O
+	/// is done.
+	using stdlogq = basic_stdlog< stream_buffer, std::chrono::system_clock,
+		global_id, deferred_sink< clog_sink > >;
+
+
+	/// \brief Confirms that a log function owns everything it refers to
+	///
+	/// Whether a lambda captures by reference can not be checked at compile
+	/// time, so deferred_log() only defers a log function if the caller
+	/// passes this tag.
+	struct by_value_t{
+		explicit by_value_t() = default;
+	};
+
+	/// \brief Confirms that a log function owns everything it refers to
+	inline constexpr by_value_t by_value{};
+
+
+	/// \brief Like log(), but execute log_f on the backend thread
+	///
+	/// log_f is moved (or copied if it is an lvalue) into a record together
+	/// with ID and time. Formatting and output happen on the backend thread,
+	/// the calling thread only pays for the record. By passing by_value the
+	/// caller confirms that log_f captures by value, the stack frame of the
+	/// caller may be gone when log_f is executed!
+	///
+	/// Falls back to log() if log_f is not deferrable. (See
+	/// detail::is_deferrable_v.) If the backend is not running, the record
+	/// is executed immediately.
+	template < typename LogF >
+	inline void deferred_log(
+		by_value_t,
+		LogF&& log_f,
+		source_location const& location = source_location::current()
+	)noexcept{
+		if constexpr(detail::is_deferrable_v< LogF, detail::nobody_t >){
+			auto& site = detail::site_of< LogF >(location);
+			if(!detail::admit< LogF, stdlog >(site)) return;
+
+			detail::post_deferred(site, static_cast< LogF&& >(log_f),
+				detail::deferred_info(site), nullptr, true);
+		}else{
+			detail::log(location, no_manipulator(), log_f);
+		}
+	}
+
+	/// \brief Like log() with body, but execute log_f on the backend thread
+	///
+	/// The body is executed by the calling thread. If log_f takes the body
+	/// result, a copy of it is passed to the backend thread.
+	template < typename LogF, typename Body >
+	inline decltype(auto) deferred_log(
+		by_value_t,
+		LogF&& log_f,
+		Body&& body,
+		source_location const& location = source_location::current()
+	){
+		using body_return_type = detail::body_return_t< Body >;
+		if constexpr(detail::is_deferrable_v< LogF, body_return_type >){
+			using value_type =
+				detail::deferred_value_t< std::decay_t< LogF >,
+					body_return_type >;
+
+			auto& site = detail::site_of< LogF >(location);
+			if(!detail::admit< LogF, stdlog >(site)){
+				return std::invoke(body);
+			}
+
+			auto info = detail::deferred_info(site);
+			auto const stop_timer = [&site, &info]{
+					info.end = std::chrono::system_clock::now();
+					detail::thread_counters< LogF >(site).add_time(
+						info.duration());
+				};
+
+			try{
+				if constexpr(std::is_void_v< body_return_type >){
+					std::invoke(body);
+					stop_timer();
+					info.body = body_state::exists;
+
+					detail::post_deferred(site, static_cast< LogF&& >(log_f),
+						info, nullptr, value_type(true));
+				}else{
+					decltype(auto) result = std::invoke(body);
+					stop_timer();
+					info.body = body_state::exists;
+
+					if constexpr(std::is_same_v< value_type, bool >){
+						detail::post_deferred(site,
+							static_cast< LogF&& >(log_f), info, nullptr, true);
+					}else{
+						detail::post_deferred(site,
+							static_cast< LogF&& >(log_f), info, nullptr,
+							value_type(std::as_const(result)));
+					}
+
+					if constexpr(std::is_reference_v< body_return_type >){
+						return static_cast< body_return_type >(result);
+					}else{
+						return result;
+					}
+				}
+			}catch(...){
+				stop_timer();
+				detail::thread_counters< LogF >(site).count_failure();
+				info.body = body_state::failed_by_exception;
+
+				detail::post_deferred(site, static_cast< LogF&& >(log_f),
+					info, std::current_exception(), value_type());
+
+				throw;
+			}
+		}else{
+			return detail::log(location, no_manipulator(), log_f, body);
+		}
+	}
+
+	/// \brief Like log(), a deferrable log_f requires by_value
+	///
+	/// A log function that captures by reference would dangle on the
+	/// backend thread, so deferring needs the explicit confirmation.
+	template < typename LogF, typename = std::enable_if_t<
+		!std::is_same_v< std::decay_t< LogF >, by_value_t > > >
+	inline void deferred_log(
+		LogF&& log_f,
+		source_location const& location = source_location::current()
+	)noexcept{
+		static_assert(!detail::is_deferrable_v< LogF, detail::nobody_t >,
+			"deferred_log needs logsys::by_value as first argument to "
+			"confirm that log_f captures by value");
+		detail::log(location, no_manipulator(), log_f);
+	}
+
+	/// \brief Like log() with body, a deferrable log_f requires by_value
+	template < typename LogF, typename Body, typename = std::enable_if_t<
+		!std::is_same_v< std::decay_t< LogF >, by_value_t > > >
+	inline decltype(auto) deferred_log(
+		LogF&& log_f,
+		Body&& body,
+		source_location const& location = source_location::current()
+	){
+		static_assert(!detail::is_deferrable_v< LogF,
+				detail::body_return_t< Body > >,
+			"deferred_log needs logsys::by_value as first argument to "
+			"confirm that log_f captures by value");
+		return detail::log(location, no_manipulator(), log_f, body);
+	}
+
+
+}
+
+
+#endif
@@ -0,0 +1,182 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__detail__append__hpp_INCLUDED_
+#define _logsys__detail__append__hpp_INCLUDED_
+
+#include <charconv>
+#include <limits>
+#include <locale>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+namespace logsys::detail{
+
+
+	/// \brief true for char, signed char and unsigned char
+	template < typename T >
+	constexpr bool is_char_v =
+		std::is_same_v< T, char > ||
+		std::is_same_v< T, signed char > ||
+		std::is_same_v< T, unsigned char >;
+
+	/// \brief true for types formatted by number_chars
+	template < typename T >
+	constexpr bool is_number_v =
+		std::is_arithmetic_v< T > && !std::is_same_v< T, bool > &&
+		!is_char_v< T >;
+
+
+	/// \brief Text of a number by std::to_chars
+	///
+	/// Integers are formatted in decimal, floating point numbers in general
+	/// format with the given precision. This is the same text as printf's
+	/// `%d` and `%.*g` and as std::ostream with default flags and classic
+	/// locale.
+	template < typename T >
+	class number_chars{
+	public:
+		static_assert(is_number_v< T >);
+
+		/// \brief Format an integer
+		template < typename U = T,
+			typename = std::enable_if_t< std::is_integral_v< U > > >
+		explicit number_chars(T value)noexcept{
+			auto const result =
+				std::to_chars(buffer_, buffer_ + sizeof(buffer_), value);
+			size_ = static_cast< std::size_t >(result.ptr - buffer_);
+		}
+
+		/// \brief Format a floating point number
+		///
+		/// Check valid() afterwards, it is false if the standard library
+		/// does not support std::to_chars for floating point numbers.
+		template < typename U = T,
+			typename = std::enable_if_t< std::is_floating_point_v< U > > >
+		number_chars(T value, int precision)noexcept{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+			auto const result = std::to_chars(buffer_,
+				buffer_ + sizeof(buffer_), value,
+				std::chars_format::general, precision);
+			if(result.ec == std::errc()){
+				size_ = static_cast< std::size_t >(result.ptr - buffer_);
+			}
+#else
+			(void)value; (void)precision; // Silance GCC
+#endif
+		}
+
+
+		/// \brief false if formatting failed
+		bool valid()const noexcept{
+			return size_ != invalid;
+		}
+
+		/// \brief The text
+		std::string_view view()const noexcept{
+			return std::string_view(buffer_, size_);
+		}
+
+
+	private:
+		/// \brief Marker of failed formatting
+		static constexpr std::size_t invalid = std::size_t(-1);
+
+		/// \brief Space for integers and reasonable precisions
+		static constexpr std::size_t buffer_size =
+			std::is_integral_v< T >
+				? std::numeric_limits< T >::digits10 + 3
+				: 64;
+
+		/// \brief The text
+		char buffer_[buffer_size];
+
+		/// \brief Size of the text
+		std::size_t size_ = invalid;
+	};
+
+
+	/// \brief Append an integer in decimal without std::ostream
+	///
+	/// Same text as `std::ostream << value` with default flags.
+	template < typename T >
+	inline void append_integer(std::string& out, T value){
+		static_assert(std::is_integral_v< T > && !std::is_same_v< T, bool >);
+		out.append(number_chars< T >(value).view());
+	}
+
+	/// \brief Append a bool as with std::boolalpha
+	inline void append_bool(std::string& out, bool value){
+		using namespace std::literals::string_view_literals;
+		out.append(value ? "true"sv : "false"sv);
+	}
+
+	/// \brief Append a floating point number as std::ostream with default
+	///        flags does
+	///
+	/// \return false if std::to_chars is not available for T
+	template < typename T >
+	inline bool append_float(std::string& out, T value){
+		number_chars< T > text(value, 6);
+		if(!text.valid()) return false;
+		out.append(text.view());
+		return true;
+	}
+
+
+	/// \brief true if os formats numbers like printf
+	///
+	/// Checks for decimal integers, general floating point format, no width,
+	/// no sign, base or point flags and the classic locale.
+	inline bool is_plain_number_format(std::ostream& os)noexcept{
+		using io = std::ios_base;
+		constexpr auto mask = io::basefield | io::floatfield | io::showpos |
+			io::showbase | io::showpoint | io::uppercase;
+		return (os.flags() & mask) == io::dec && os.width() == 0 &&
+			os.getloc() == std::locale::classic();
+	}
+
+	/// \brief Output a number, bypass the std::num_put facet if possible
+	///
+	/// The text is the same as by `os << value`.
+	template < typename T >
+	inline void write_number(std::ostream& os, T value){
+		static_assert(is_number_v< T >);
+
+		if(is_plain_number_format(os)){
+			if constexpr(std::is_integral_v< T >){
+				auto const text = number_chars< T >(value).view();
+				os.write(text.data(),
+					static_cast< std::streamsize >(text.size()));
+				return;
+			}else{
+				auto const precision = os.precision();
+				if(precision >= 0 && precision <= 32){
+					number_chars< T > text(value,
+						static_cast< int >(precision));
+					if(text.valid()){
+						auto const view = text.view();
+						os.write(view.data(),
+							static_cast< std::streamsize >(view.size()));
+						return;
+					}
+				}
+			}
+		}
+
+		os << value;
+	}
+
+
+}
+
+
+#endif
@@ -0,0 +1,169 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__detail__arena__hpp_INCLUDED_
+#define _logsys__detail__arena__hpp_INCLUDED_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+
+namespace logsys::detail{
+
+
+	/// \brief Piece of a message in a message_arena chunk
+	///
+	/// The text follows the header directly.
+	struct arena_segment{
+		/// \brief Next piece of the same message
+		arena_segment* next;
+
+		/// \brief Previous piece of the same message
+		arena_segment* previous;
+
+		/// \brief Bytes of text behind the header
+		std::size_t size;
+
+		/// \brief Chunk index of the arena before the segment was created
+		std::size_t below_chunk;
+
+		/// \brief Top of the arena before the segment was created
+		std::size_t below_top;
+
+		/// \brief The text
+		char* data()noexcept{
+			return reinterpret_cast< char* >(this + 1);
+		}
+
+		/// \brief The text
+		char const* data()const noexcept{
+			return reinterpret_cast< char const* >(this + 1);
+		}
+	};
+
+
+	/// \brief Per thread bump allocator for message text
+	///
+	/// Memory is taken from the top of the current chunk. A message whose
+	/// segment is on top grows in place, otherwise it gets a new segment.
+	/// Messages larger than a chunk become a chain of segments in several
+	/// chunks. Like a stack, a segment on top is removed by pop() when its
+	/// message is done, so nested messages of a long living outer message
+	/// reuse the same memory. Segments below a newer one stay until the
+	/// last user is released, then the top is reset to the begin of the
+	/// first chunk. Chunks are kept for the next messages.
+	class message_arena{
+	public:
+		/// \brief Bytes per chunk
+		static constexpr std::size_t chunk_size = 16384;
+
+		/// \brief Minimal text bytes of a new segment
+		static constexpr std::size_t min_segment = 64;
+
+
+		/// \brief The arena of the calling thread
+		static message_arena& local()noexcept{
+			thread_local message_arena arena;
+			return arena;
+		}
+
+
+		/// \brief Register a user
+		void acquire()noexcept{
+			++users_;
+		}
+
+		/// \brief Unregister a user, reset if it was the last one
+		void release()noexcept{
+			if(--users_ == 0){
+				chunk_ = 0;
+				top_ = 0;
+			}
+		}
+
+		/// \brief Create a new empty segment on top
+		arena_segment* new_segment(){
+			auto const below_chunk = chunk_;
+			auto const below_top = top_;
+
+			constexpr auto align = alignof(arena_segment);
+			auto offset = (top_ + align - 1) / align * align;
+			if(chunk_ >= chunks_.size()
+				|| offset + sizeof(arena_segment) + min_segment > chunk_size
+			){
+				if(chunk_ < chunks_.size()) ++chunk_;
+				if(chunk_ == chunks_.size()){
+					chunks_.push_back(std::make_unique< char[] >(chunk_size));
+				}
+				offset = 0;
+			}
+
+			auto const segment = new(chunks_[chunk_].get() + offset)
+				arena_segment{nullptr, nullptr, 0, below_chunk, below_top};
+			top_ = offset + sizeof(arena_segment);
+			return segment;
+		}
+
+		/// \brief Remove segment if it is on top
+		///
+		/// \return false if a newer segment exists
+		bool pop(arena_segment const& segment)noexcept{
+			if(chunk_ >= chunks_.size()) return false;
+			auto const top = chunks_[chunk_].get() + top_;
+			if(segment.data() + segment.size != top) return false;
+
+			chunk_ = segment.below_chunk;
+			top_ = segment.below_top;
+			return true;
+		}
+
+		/// \brief Append text to segment if it is on top
+		///
+		/// \return Count of appended bytes
+		std::size_t extend(arena_segment& segment, std::string_view text)
+		noexcept{
+			if(chunk_ >= chunks_.size()) return 0;
+			auto const top = chunks_[chunk_].get() + top_;
+			if(segment.data() + segment.size != top) return 0;
+
+			auto const count = std::min(text.size(), chunk_size - top_);
+			std::memcpy(top, text.data(), count);
+			segment.size += count;
+			top_ += count;
+			return count;
+		}
+
+		/// \brief Count of allocated chunks
+		std::size_t chunk_count()const noexcept{
+			return chunks_.size();
+		}
+
+
+	private:
+		/// \brief The memory
+		std::vector< std::unique_ptr< char[] > > chunks_;
+
+		/// \brief Index of the current chunk
+		std::size_t chunk_ = 0;
+
+		/// \brief First free byte in the current chunk
+		std::size_t top_ = 0;
+
+		/// \brief Count of living users
+		std::size_t users_ = 0;
+	};
+
+
+}
+
+
+#endif
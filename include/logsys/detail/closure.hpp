@@ -0,0 +1,218 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__detail__closure__hpp_INCLUDED_
+#define _logsys__detail__closure__hpp_INCLUDED_
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+
+namespace logsys::detail{
+
+
+	/// \brief true if T has a member function `footprint()`
+	template < typename T, typename = void >
+	struct has_footprint: std::false_type{};
+
+	template < typename T >
+	struct has_footprint< T,
+		std::void_t< decltype(std::declval< T const& >().footprint()) > >
+		: std::true_type{};
+
+	/// \brief true if T is a std::basic_string
+	template < typename T >
+	struct is_basic_string: std::false_type{};
+
+	template < typename ... T >
+	struct is_basic_string< std::basic_string< T ... > >: std::true_type{};
+
+	/// \brief true if T is a std::optional
+	template < typename T >
+	struct is_std_optional: std::false_type{};
+
+	template < typename T >
+	struct is_std_optional< std::optional< T > >: std::true_type{};
+
+
+	/// \brief Heap bytes owned by value
+	///
+	/// A type with a member function `std::size_t footprint()const noexcept`
+	/// reports its own heap bytes. Strings count their capacity if it is
+	/// not stored in place, optionals count their value. All other types,
+	/// including lambdas, count 0, their captures are invisible.
+	template < typename T >
+	std::size_t owned_bytes(T const& value)noexcept{
+		if constexpr(has_footprint< T >::value){
+			return value.footprint();
+		}else if constexpr(is_basic_string< T >::value){
+			auto const data =
+				reinterpret_cast< unsigned char const* >(value.data());
+			auto const self = reinterpret_cast< unsigned char const* >(&value);
+			std::less< unsigned char const* > const less;
+			auto const inplace =
+				!less(data, self) && less(data, self + sizeof(T));
+			return inplace ? 0 :
+				(value.capacity() + 1) * sizeof(typename T::value_type);
+		}else if constexpr(is_std_optional< T >::value){
+			return value ? owned_bytes(*value) : 0;
+		}else{
+			return 0;
+		}
+	}
+
+
+	/// \brief Move only type erased `void()` callable
+	///
+	/// Callables up to buffer_size bytes with a nothrow move constructor are
+	/// stored in place, bigger ones on the heap.
+	class closure{
+	public:
+		/// \brief Size of the in place storage
+		static constexpr std::size_t buffer_size = 96;
+
+		/// \brief true if F is stored in place
+		template < typename F >
+		static constexpr bool is_inplace_v =
+			sizeof(F) <= buffer_size &&
+			alignof(F) <= alignof(std::max_align_t) &&
+			std::is_nothrow_move_constructible_v< F >;
+
+
+		/// \brief Construct an empty closure
+		closure()noexcept = default;
+
+		/// \brief Store f
+		template < typename F, typename = std::enable_if_t<
+			!std::is_same_v< std::decay_t< F >, closure > > >
+		closure(F&& f){
+			using type = std::decay_t< F >;
+			if constexpr(is_inplace_v< type >){
+				::new(static_cast< void* >(buffer_))
+					type(static_cast< F&& >(f));
+				ops_ = &inplace_ops< type >;
+			}else{
+				*reinterpret_cast< type** >(buffer_) =
+					new type(static_cast< F&& >(f));
+				ops_ = &heap_ops< type >;
+			}
+		}
+
+		closure(closure&& other)noexcept{
+			move_from(other);
+		}
+
+		closure& operator=(closure&& other)noexcept{
+			if(this != &other){
+				reset();
+				move_from(other);
+			}
+			return *this;
+		}
+
+		/// \brief Destroy the stored callable
+		~closure(){
+			reset();
+		}
+
+
+		/// \brief Call the stored callable
+		///
+		/// The closure must not be empty.
+		void operator()(){
+			ops_->invoke(buffer_);
+		}
+
+		/// \brief true if not empty
+		explicit operator bool()const noexcept{
+			return ops_ != nullptr;
+		}
+
+		/// \brief Bytes occupied by the closure, its heap object and the
+		///        heap memory owned by the callable
+		///
+		/// The owned memory is counted by owned_bytes(), so heap memory of
+		/// lambda captures is not included.
+		std::size_t footprint()const noexcept{
+			return ops_ != nullptr
+				? sizeof(closure) + ops_->heap_size + ops_->owned(buffer_)
+				: sizeof(closure);
+		}
+
+
+	private:
+		/// \brief Type specific operations
+		struct operations{
+			void(*invoke)(void* self);
+			void(*move)(void* from, void* to)noexcept;
+			void(*destroy)(void* self)noexcept;
+			std::size_t(*owned)(void const* self)noexcept;
+			std::size_t heap_size;
+		};
+
+		template < typename F >
+		static constexpr operations inplace_ops{
+			[](void* self){ (*static_cast< F* >(self))(); },
+			[](void* from, void* to)noexcept{
+				::new(to) F(std::move(*static_cast< F* >(from)));
+				static_cast< F* >(from)->~F();
+			},
+			[](void* self)noexcept{ static_cast< F* >(self)->~F(); },
+			[](void const* self)noexcept{
+				return owned_bytes(*static_cast< F const* >(self));
+			},
+			0
+		};
+
+		template < typename F >
+		static constexpr operations heap_ops{
+			[](void* self){ (**static_cast< F** >(self))(); },
+			[](void* from, void* to)noexcept{
+				*static_cast< F** >(to) = *static_cast< F** >(from);
+			},
+			[](void* self)noexcept{ delete *static_cast< F** >(self); },
+			[](void const* self)noexcept{
+				return owned_bytes(**static_cast< F* const* >(self));
+			},
+			sizeof(F)
+		};
+
+
+		/// \brief Take the callable of other, other becomes empty
+		void move_from(closure& other)noexcept{
+			if(other.ops_ == nullptr) return;
+			other.ops_->move(other.buffer_, buffer_);
+			ops_ = other.ops_;
+			other.ops_ = nullptr;
+		}
+
+		/// \brief Destroy the callable, closure becomes empty
+		void reset()noexcept{
+			if(ops_ == nullptr) return;
+			ops_->destroy(buffer_);
+			ops_ = nullptr;
+		}
+
+
+		/// \brief Storage of the callable or a pointer to it
+		alignas(std::max_align_t) unsigned char buffer_[buffer_size];
+
+		/// \brief Operations of the stored type, nullptr if empty
+		operations const* ops_ = nullptr;
+	};
+
+
+}
+
+
+#endif
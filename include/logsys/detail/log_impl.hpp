@@ -12,6 +12,8 @@
 #include "extract_log_t.hpp"
 #include "log_trait.hpp"
 
+#include "../call_site.hpp"
+
 #include <functional>
 #include <cassert>
 
@@ -57,6 +59,120 @@ namespace logsys::detail{
 		body_return_type< Body >::is_nothrow_invocable_v;
 
 
+	/// \brief Counters of the call site of LogF for the calling thread
+	template < typename LogF >
+	inline site_counters& thread_counters(call_site& site)noexcept{
+		using key = std::remove_cv_t< std::remove_reference_t< LogF > >;
+		return counters_of< key >(site);
+	}
+
+
+	/// \brief true if Log provides the times of the body by info()
+	template < typename Log >
+	constexpr bool has_body_times = [](){
+			if constexpr(log_trait< Log >::has_body_finished && is_valid< Log >(
+				[](auto& x)->decltype((void)x.info().duration()){})
+			){
+				return noexcept(std::declval< Log& >().info());
+			}else{
+				return false;
+			}
+		}();
+
+	/// \brief Measures the runtime of a body function for its call site
+	///
+	/// The times of Log types with info() are reused, other Log types are
+	/// measured by std::chrono::steady_clock.
+	template < typename LogF, typename Log >
+	class body_timer{
+	public:
+		/// \brief Save start time if Log does not
+		body_timer(call_site& site, Log& log)noexcept
+			: site_(site)
+			, log_(log)
+		{
+			if constexpr(!has_body_times< Log >){
+				start_ = std::chrono::steady_clock::now();
+			}
+		}
+
+		/// \brief Add the runtime to the call site, call it after
+		///        body_finished()
+		void stop()noexcept{
+			auto& counters = thread_counters< LogF >(site_);
+			if constexpr(has_body_times< Log >){
+				counters.add_time(log_.info().duration());
+			}else{
+				counters.add_time(std::chrono::steady_clock::now() - start_);
+			}
+		}
+
+	private:
+		/// \brief The measured call site
+		call_site& site_;
+
+		/// \brief The log object of the call
+		Log const& log_;
+
+		/// \brief Time point before body function is executed
+		std::chrono::steady_clock::time_point start_;
+	};
+
+
+	/// \brief Set the level of the call site on the log object
+	template < typename Log >
+	inline void set_site_level(call_site& site, Log& log)noexcept{
+		if constexpr(log_trait< Log >::has_set_level){
+			if(auto const level = site.level()){
+				log.set_level(*level);
+			}
+		}else{
+			(void)site; (void)log; // Silance GCC
+		}
+	}
+
+
+	/// \brief Output a line about suppressed calls if Log supports it
+	template < typename Log >
+	inline void log_suppressed(std::uint64_t count)noexcept{
+		if constexpr(is_valid< Log >([](auto& x)->decltype((void)(
+			x << "" << std::uint64_t()
+		)){})){
+			if(count == 0) return;
+
+			auto log = Log();
+
+			try{
+				log << "suppressed " << count << " messages";
+			}catch(...){
+				log.set_log_exception(std::current_exception());
+			}
+
+			log.exec();
+		}else{
+			(void)count; // Silance GCC
+		}
+	}
+
+	/// \brief true if the call site logs this call
+	///
+	/// Decides by enable flag, sampling and rate limit before the log
+	/// object is constructed.
+	template < typename LogF, typename Log >
+	inline bool admit(call_site& site)noexcept{
+		if(!site.enabled()) return false;
+
+		if(!site.admit([]()noexcept->std::uint32_t&{
+				return sampling_counter_of<
+					std::remove_cv_t< std::remove_reference_t< LogF > > >();
+			})) return false;
+
+		thread_counters< LogF >(site).count_call();
+		log_suppressed< Log >(site.take_pending_suppressed());
+		return true;
+	}
+
+
 	/// \brief Execute user defined log function and call `exec` on log object
 	///
 	/// Call `set_log_exception` before `exec` if user defined log function
@@ -67,6 +183,7 @@ namespace logsys::detail{
 		typename Log,
 		typename BodyRT >
 	inline void exec_log(
+		call_site& site,
 		ManipulatorF& manipulator_f,
 		LogF& log_f,
 		Log& log,
@@ -82,6 +199,9 @@ namespace logsys::detail{
 				std::invoke(log_f, log, return_value);
 			}
 		}catch(...){
+			// an empty return value means the body failed, which is
+			// counted already
+			if(return_value) thread_counters< LogF >(site).count_failure();
 			log.set_log_exception(std::current_exception());
 		}
 
@@ -94,14 +214,19 @@ namespace logsys::detail{
 		typename LogF,
 		typename Log >
 	inline void log_impl(
+		call_site& site,
 		ManipulatorF& manipulator_f,
 		LogF& log_f
 	)noexcept{
+		if(!admit< LogF, Log >(site)) return;
+
 		auto log = Log();
+		set_site_level(site, log);
 
 		try{
 			std::invoke(log_f, log);
 		}catch(...){
+			thread_counters< LogF >(site).count_failure();
 			log.set_log_exception(std::current_exception());
 		}
 
@@ -116,31 +241,40 @@ namespace logsys::detail{
 		typename Body,
 		typename BodyRT >
 	inline BodyRT log_impl(
+		call_site& site,
 		ManipulatorF& manipulator_f,
 		LogF& log_f,
 		Body& body
 	)noexcept(is_body_nothrow_v< Body >){
+		if(!admit< LogF, Log >(site)){
+			return std::invoke(body);
+		}
+
 		auto log = Log();
+		set_site_level(site, log);
+		body_timer< LogF, Log > timer(site, log);
 
 		try{
 			if constexpr(std::is_void_v< BodyRT >){
 				std::invoke(body);
-
 				if constexpr(log_trait< Log >::has_body_finished){
 					log.body_finished();
 				}
 
+				timer.stop();
+
 				exec_log< ManipulatorF, LogF, Log, BodyRT >(
-					manipulator_f, log_f, log, true);
+					site, manipulator_f, log_f, log, true);
 			}else{
 				optional< BodyRT > body_value(std::invoke(body));
-
 				if constexpr(log_trait< Log >::has_body_finished){
 					log.body_finished();
 				}
 
+				timer.stop();
+
 				exec_log< ManipulatorF, LogF, Log, BodyRT >(
-					manipulator_f, log_f, log, body_value);
+					site, manipulator_f, log_f, log, body_value);
 
 				// BUG: Move constructor may throw
 				// TODO: Find a way to use RVO
@@ -154,17 +288,35 @@ namespace logsys::detail{
 					log.body_finished();
 				}
 
+				timer.stop();
+				thread_counters< LogF >(site).count_failure();
+
 				log.set_body_exception(std::current_exception(), true);
 
 				auto body_value = optional< BodyRT >();
 				exec_log< ManipulatorF, LogF, Log, BodyRT >(
-					manipulator_f, log_f, log, body_value);
+					site, manipulator_f, log_f, log, body_value);
 
 				throw;
 			}
 		}
 	}
 
+	/// \brief Execute body function and catch all exceptions without log
+	template < typename Body, typename BodyRT >
+	inline optional< BodyRT > exception_catching_body(Body& body)noexcept{
+		try{
+			if constexpr(std::is_void_v< BodyRT >){
+				std::invoke(body);
+				return true;
+			}else{
+				return optional< BodyRT >(std::invoke(body));
+			}
+		}catch(...){
+			return optional< BodyRT >();
+		}
+	}
+
 	/// \brief Exception catching log (with a body function)
 	template <
 		typename ManipulatorF,
@@ -174,33 +326,42 @@ namespace logsys::detail{
 		typename BodyRT >
 	inline optional< BodyRT >
 	exception_catching_log_impl(
+		call_site& site,
 		ManipulatorF& manipulator_f,
 		LogF& log_f,
 		Body& body
 	)noexcept{
+		if(!admit< LogF, Log >(site)){
+			return exception_catching_body< Body, BodyRT >(body);
+		}
+
 		auto log = Log();
+		set_site_level(site, log);
+		body_timer< LogF, Log > timer(site, log);
 
 		try{
 			if constexpr(std::is_void_v< BodyRT >){
 				std::invoke(body);
-
 				if constexpr(log_trait< Log >::has_body_finished){
 					log.body_finished();
 				}
 
+				timer.stop();
+
 				exec_log< ManipulatorF, LogF, Log, BodyRT >(
-					manipulator_f, log_f, log, true);
+					site, manipulator_f, log_f, log, true);
 
 				return true;
 			}else{
 				optional< BodyRT > body_value(std::invoke(body));
-
 				if constexpr(log_trait< Log >::has_body_finished){
 					log.body_finished();
 				}
 
+				timer.stop();
+
 				exec_log< ManipulatorF, LogF, Log, BodyRT >(
-					manipulator_f, log_f, log, body_value);
+					site, manipulator_f, log_f, log, body_value);
 
 				return body_value;
 			}
@@ -209,19 +370,34 @@ namespace logsys::detail{
 				log.body_finished();
 			}
 
+			timer.stop();
+			thread_counters< LogF >(site).count_failure();
+
 			log.set_body_exception(std::current_exception(), false);
 
 			auto body_value = optional< BodyRT >();
 			exec_log< ManipulatorF, LogF, Log, BodyRT >(
-				manipulator_f, log_f, log, body_value);
+				site, manipulator_f, log_f, log, body_value);
 
 			return body_value;
 		}
 	}
 
 
+	/// \brief Get the call site descriptor of LogF
+	template < typename LogF >
+	inline call_site& site_of(source_location const& location)noexcept{
+		return call_site_of< std::remove_cv_t< std::remove_reference_t< LogF > > >(
+			location);
+	}
+
+
 	template < typename ManipulatorF, typename LogF >
-	inline void log(ManipulatorF&& manipulator_f, LogF&& log_f)noexcept{
+	inline void log(
+		source_location const& location,
+		ManipulatorF&& manipulator_f,
+		LogF&& log_f
+	)noexcept{
 		static_assert(detail::is_extract_log_valid_v< LogF, detail::nobody_t >,
 			"Can not extract Log type from first parameter of the log "
 			"function. "
@@ -236,11 +412,13 @@ namespace logsys::detail{
 			"A valid log()-call without body must have the form: "
 			"'logsys::log([](Log&){});' where Log is your Log type.");
 
-		log_impl< ManipulatorF, LogF, log_type >(manipulator_f, log_f);
+		log_impl< ManipulatorF, LogF, log_type >(
+			site_of< LogF >(location), manipulator_f, log_f);
 	}
 
 	template < typename ManipulatorF, typename LogF, typename Body >
 	inline decltype(auto) log(
+		source_location const& location,
 		ManipulatorF&& manipulator_f,
 		LogF&& log_f,
 		Body&& body
@@ -259,11 +437,13 @@ namespace logsys::detail{
 		(void)manipulator_assert< ManipulatorF, log_type >{};
 
 		return log_impl< ManipulatorF, LogF, log_type,
-			Body, body_return_type >(manipulator_f, log_f, body);
+			Body, body_return_type >(
+				site_of< LogF >(location), manipulator_f, log_f, body);
 	}
 
 	template < typename ManipulatorF, typename LogF, typename Body >
 	inline auto exception_catching_log(
+		source_location const& location,
 		ManipulatorF&& manipulator_f,
 		LogF&& log_f,
 		Body&& body
@@ -283,7 +463,8 @@ namespace logsys::detail{
 		(void)manipulator_assert< ManipulatorF, log_type >{};
 
 		return exception_catching_log_impl< ManipulatorF, LogF, log_type,
-			Body, body_return_type >(manipulator_f, log_f, body);
+			Body, body_return_type >(
+				site_of< LogF >(location), manipulator_f, log_f, body);
 	}
 
 
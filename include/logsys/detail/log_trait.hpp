@@ -11,6 +11,8 @@
 
 #include "type_traits.hpp"
 
+#include "../level.hpp"
+
 #include <functional>
 #include <exception>
 #include <memory>
@@ -112,6 +114,14 @@ namespace logsys{
 			"Log member function .body_finished() must be nothrow callable.");
 
 
+		/// \brief true if Log has a set_level member function with one
+		///        argument of type logsys::level, otherwise false
+		static constexpr bool has_set_level = detail::is_valid< Log >(
+			[](auto& x)->decltype(
+				(void)x.set_level(std::declval< level >())
+			){});
+
+
 		static_assert(
 			std::is_nothrow_default_constructible_v< Log >,
 			"Log must be nothrow default constructible");
@@ -0,0 +1,117 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__detail__page_buffer__hpp_INCLUDED_
+#define _logsys__detail__page_buffer__hpp_INCLUDED_
+
+#include <cstddef>
+
+
+namespace logsys{
+
+
+	/// \brief Page type of log buffers
+	enum class huge_pages{
+		/// \brief Normal pages
+		none,
+
+		/// \brief Transparent huge pages, if enabled by the system
+		transparent,
+
+		/// \brief Huge pages from the hugetlbfs pool, normal pages if the
+		///        pool is empty
+		hugetlb
+	};
+
+
+	namespace detail{
+
+
+		/// \brief Page aligned memory directly from the operating system
+		class [[gnu::visibility("default")]] page_buffer{
+		public:
+			/// \brief Size of a huge page
+			static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+
+			/// \brief No memory
+			page_buffer()noexcept = default;
+
+			/// \brief Allocate at least size bytes
+			///
+			/// The size is rounded up to whole pages.
+			///
+			/// \param size Minimal size
+			/// \param pages Page type
+			/// \param prefault Touch every page now, so no page fault happens
+			///                 on first use
+			/// \param lock Lock the pages in RAM by mlock(), fails silently
+			///             if not permitted
+			///
+			/// \throw std::bad_alloc
+			page_buffer(
+				std::size_t size,
+				huge_pages pages,
+				bool prefault,
+				bool lock);
+
+			page_buffer(page_buffer&& other)noexcept;
+
+			page_buffer& operator=(page_buffer&& other)noexcept;
+
+			/// \brief Free the memory
+			~page_buffer();
+
+
+			/// \brief The memory
+			void* data()const noexcept{
+				return data_;
+			}
+
+			/// \brief Size in bytes
+			std::size_t size()const noexcept{
+				return size_;
+			}
+
+			/// \brief true if huge pages were requested successfully
+			bool huge()const noexcept{
+				return huge_;
+			}
+
+			/// \brief true if the memory is locked in RAM
+			bool locked()const noexcept{
+				return locked_;
+			}
+
+
+		private:
+			/// \brief Free the memory
+			void release()noexcept;
+
+
+			/// \brief The memory
+			void* data_ = nullptr;
+
+			/// \brief Size in bytes
+			std::size_t size_ = 0;
+
+			/// \brief true if allocated with huge pages
+			bool huge_ = false;
+
+			/// \brief true if locked in RAM
+			bool locked_ = false;
+		};
+
+
+	}
+
+
+}
+
+
+#endif
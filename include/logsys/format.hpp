@@ -0,0 +1,266 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__format__hpp_INCLUDED_
+#define _logsys__format__hpp_INCLUDED_
+
+#include "detail/append.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+
+#ifdef __cpp_consteval
+#define LOGSYS_CONSTEVAL consteval
+#else
+#define LOGSYS_CONSTEVAL constexpr
+#endif
+
+
+namespace logsys{
+
+
+	namespace detail{
+
+
+		/// \brief Count the `{}` placeholders in text
+		///
+		/// `{{` and `}}` are escaped braces.
+		///
+		/// \return nullptr or the error message if text contains other
+		///         braces
+		constexpr char const* scan_placeholders(
+			std::string_view text,
+			std::size_t& count
+		)noexcept{
+			count = 0;
+			for(std::size_t i = 0; i < text.size(); ++i){
+				if(text[i] == '{'){
+					if(i + 1 < text.size() && text[i + 1] == '{'){
+						++i;
+					}else if(i + 1 < text.size() && text[i + 1] == '}'){
+						++i;
+						++count;
+					}else{
+						return "format string: '{' must be followed by '{' "
+							"or '}'";
+					}
+				}else if(text[i] == '}'){
+					if(i + 1 < text.size() && text[i + 1] == '}'){
+						++i;
+					}else{
+						return "format string: unmatched '}'";
+					}
+				}
+			}
+			return nullptr;
+		}
+
+		/// \brief Number of `{}` placeholders in text
+		///
+		/// `{{` and `}}` are escaped braces.
+		///
+		/// \throw std::invalid_argument if text contains other braces
+		constexpr std::size_t count_placeholders(std::string_view text){
+			std::size_t count = 0;
+			if(auto const error = scan_placeholders(text, count)){
+				throw std::invalid_argument(error);
+			}
+			return count;
+		}
+
+		/// \brief true if text is a format string for count arguments
+		constexpr bool is_format_string(
+			std::string_view text,
+			std::size_t count
+		)noexcept{
+			std::size_t placeholders = 0;
+			return scan_placeholders(text, placeholders) == nullptr
+				&& placeholders == count;
+		}
+
+		/// \brief Not constexpr, so a call makes a consteval check fail
+		inline void invalid_format_string()noexcept{}
+
+
+	}
+
+
+	/// \brief A format string with ArgCount `{}` placeholders
+	///
+	/// If the compiler supports consteval, the string is checked at compile
+	/// time. Otherwise it is checked at runtime and a mismatch throws
+	/// std::invalid_argument (which the log function reports as log
+	/// exception).
+	template < std::size_t ArgCount >
+	class format_string{
+	public:
+		/// \brief Check text
+		template < typename S, typename = std::enable_if_t<
+			std::is_convertible_v< S const&, std::string_view > > >
+		LOGSYS_CONSTEVAL format_string(S const& text)
+			: text_(text)
+		{
+			if(detail::count_placeholders(text_) != ArgCount){
+				throw std::invalid_argument(
+					"format string: number of '{}' and arguments differ");
+			}
+		}
+
+
+		/// \brief The text
+		constexpr std::string_view get()const noexcept{
+			return text_;
+		}
+
+
+	private:
+		/// \brief The text
+		std::string_view text_;
+	};
+
+
+	/// \brief A format string with ArgCount `{}` placeholders that never
+	///        throws
+	///
+	/// Like format_string, but without consteval a mismatch is not thrown
+	/// at runtime, valid() returns false instead. For log types that must
+	/// neither throw nor allocate, like rtlog.
+	template < std::size_t ArgCount >
+	class nothrow_format_string{
+	public:
+		/// \brief Check text
+		template < typename S, typename = std::enable_if_t<
+			std::is_convertible_v< S const&, std::string_view > > >
+		LOGSYS_CONSTEVAL nothrow_format_string(S const& text)noexcept
+			: text_(text)
+			, valid_(detail::is_format_string(text_, ArgCount))
+		{
+#ifdef __cpp_consteval
+			if(!valid_) detail::invalid_format_string();
+#endif
+		}
+
+
+		/// \brief The text
+		constexpr std::string_view get()const noexcept{
+			return text_;
+		}
+
+		/// \brief true if text matches ArgCount
+		constexpr bool valid()const noexcept{
+			return valid_;
+		}
+
+
+	private:
+		/// \brief The text
+		std::string_view text_;
+
+		/// \brief true if text matches ArgCount
+		bool valid_;
+	};
+
+
+	namespace detail{
+
+
+		/// \brief Append the literal text up to the next placeholder
+		///
+		/// Removes the escapes and the placeholder from fmt.
+		template < typename TextF >
+		inline void format_literal(std::string_view& fmt, TextF& text_f){
+			while(!fmt.empty()){
+				auto const pos = fmt.find_first_of("{}");
+				if(pos == std::string_view::npos){
+					text_f(fmt);
+					fmt = std::string_view();
+					return;
+				}
+
+				if(pos > 0) text_f(fmt.substr(0, pos));
+
+				// fmt is checked, so a brace is followed by a second one
+				auto const is_placeholder =
+					fmt[pos] == '{' && fmt[pos + 1] == '}';
+				if(!is_placeholder) text_f(fmt.substr(pos, 1));
+
+				fmt.remove_prefix(pos + 2);
+				if(is_placeholder) return;
+			}
+		}
+
+		/// \brief Split fmt at its placeholders
+		///
+		/// Calls text_f(string_view) for the literal parts and arg_f(arg) for
+		/// every argument in order. fmt must be checked already.
+		template < typename TextF, typename ArgF, typename ... Args >
+		inline void format_parts(
+			std::string_view fmt,
+			TextF&& text_f,
+			ArgF&& arg_f,
+			Args&& ... args
+		){
+			((format_literal(fmt, text_f), arg_f(static_cast< Args&& >(args))),
+				...);
+			format_literal(fmt, text_f);
+		}
+
+
+		/// \brief Append a value as stdlog's operator<< would output it
+		template < typename T >
+		inline void append_value(std::string& out, T const& value){
+			if constexpr(is_char_v< T >){
+				append_integer(out, static_cast< int >(value));
+			}else if constexpr(std::is_same_v< T, bool >){
+				append_bool(out, value);
+			}else if constexpr(std::is_integral_v< T >){
+				append_integer(out, value);
+			}else if constexpr(std::is_floating_point_v< T >){
+				if(!append_float(out, value)){
+					std::ostringstream os;
+					os << value;
+					out += os.str();
+				}
+			}else if constexpr(std::is_convertible_v< T const&, char const* >){
+				char const* const text = value;
+				if(text != nullptr) out.append(text);
+			}else if constexpr(
+				std::is_convertible_v< T const&, std::string_view >
+			){
+				out.append(std::string_view(value));
+			}else{
+				std::ostringstream os;
+				os << std::boolalpha << value;
+				out += os.str();
+			}
+		}
+
+		/// \brief Append the formatted text to out
+		template < std::size_t ArgCount, typename ... Args >
+		inline void format_to(
+			std::string& out,
+			format_string< ArgCount > const& fmt,
+			Args const& ... args
+		){
+			format_parts(fmt.get(),
+				[&out](std::string_view text){ out.append(text); },
+				[&out](auto const& arg){ append_value(out, arg); },
+				args ...);
+		}
+
+
+	}
+
+
+}
+
+
+#endif
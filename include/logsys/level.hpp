@@ -0,0 +1,35 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__level__hpp_INCLUDED_
+#define _logsys__level__hpp_INCLUDED_
+
+
+namespace logsys{
+
+
+	/// \brief Severity of a log message
+	///
+	/// Insert it into a log object to set the level of the message:
+	///
+	/// \code{.cpp}
+	/// log([](stdlogb& os){ os << level::warning << "your message"; });
+	/// \endcode
+	enum class level{
+		trace,
+		debug,
+		info,
+		warning,
+		error
+	};
+
+
+}
+
+
+#endif
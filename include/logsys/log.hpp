@@ -29,8 +29,11 @@ namespace logsys{
 	/// log([](your_log_type& os){ os << "your message"; });
 	/// \endcode
 	template < typename LogF >
-	inline void log(LogF&& log_f)noexcept{
-		detail::log(no_manipulator(), log_f);
+	inline void log(
+		LogF&& log_f,
+		source_location const& location = source_location::current()
+	)noexcept{
+		detail::log(location, no_manipulator(), log_f);
 	}
 
 	/// \brief Add a log message with associated code block
@@ -49,8 +52,12 @@ namespace logsys{
 	///     });
 	/// \endcode
 	template < typename LogF, typename Body >
-	inline decltype(auto) log(LogF&& log_f, Body&& body){
-		return detail::log(no_manipulator(), log_f, body);
+	inline decltype(auto) log(
+		LogF&& log_f,
+		Body&& body,
+		source_location const& location = source_location::current()
+	){
+		return detail::log(location, no_manipulator(), log_f, body);
 	}
 
 	/// \brief Catch all exceptions
@@ -79,8 +86,13 @@ namespace logsys{
 	///     });
 	/// \endcode
 	template < typename LogF, typename Body >
-	inline auto exception_catching_log(LogF&& log_f, Body&& body)noexcept{
-		return detail::exception_catching_log(no_manipulator(), log_f, body);
+	inline auto exception_catching_log(
+		LogF&& log_f,
+		Body&& body,
+		source_location const& location = source_location::current()
+	)noexcept{
+		return detail::exception_catching_log(
+			location, no_manipulator(), log_f, body);
 	}
 
 
@@ -20,24 +20,34 @@ namespace logsys{
 	public:
 		/// \brief Add a line to the log
 		template < typename LogF >
-		void log(LogF&& f)const noexcept{
-			ref_.log(static_cast< LogF&& >(f));
+		void log(
+			LogF&& f,
+			source_location const& location = source_location::current()
+		)const noexcept{
+			ref_.log(static_cast< LogF&& >(f), location);
 		}
 
 		/// \brief Add a line to the log with linked code block
 		template < typename LogF, typename Body >
-		decltype(auto) log(LogF&& f, Body&& body)const
-		noexcept(detail::is_body_nothrow_v< Body >){ // TODO: static_assert that checks body must be called first
-			return ref_.log(
-				static_cast< LogF&& >(f), static_cast< Body&& >(body));
+		decltype(auto) log(
+			LogF&& f,
+			Body&& body,
+			source_location const& location = source_location::current()
+		)const noexcept(detail::is_body_nothrow_v< Body >){ // TODO: static_assert that checks body must be called first
+			return ref_.log(static_cast< LogF&& >(f),
+				static_cast< Body&& >(body), location);
 		}
 
 		/// \brief Add a line to the log with linked code block and catch all
 		///        exceptions
 		template < typename LogF, typename Body >
-		auto exception_catching_log(LogF&& f, Body&& body)const noexcept{
-			return ref_.exception_catching_log(
-				static_cast< LogF&& >(f), static_cast< Body&& >(body));
+		auto exception_catching_log(
+			LogF&& f,
+			Body&& body,
+			source_location const& location = source_location::current()
+		)const noexcept{
+			return ref_.exception_catching_log(static_cast< LogF&& >(f),
+				static_cast< Body&& >(body), location);
 		}
 
 
@@ -0,0 +1,88 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__record_info__hpp_INCLUDED_
+#define _logsys__record_info__hpp_INCLUDED_
+
+#include "level.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <string_view>
+
+
+namespace logsys{
+
+
+	/// \brief Info about the body of a log message
+	enum class body_state{
+		none,
+		exists,
+		failed_by_exception,
+		catched_exception,
+	};
+
+
+	/// \brief Meta data of a log record
+	///
+	/// Everything that is known about a record without formatting its line.
+	struct record_info{
+		/// \brief The unique ID of the log message
+		std::size_t id;
+
+		/// \brief Time point before associated code block is executed
+		std::chrono::system_clock::time_point start;
+
+		/// \brief Time point after associated code block is executed
+		std::chrono::system_clock::time_point end;
+
+		/// \brief The body indicator
+		body_state body;
+
+		/// \brief true if the log function throw an exception
+		bool log_exception;
+
+		/// \brief Severity of the message
+		logsys::level level;
+
+
+		/// \brief Runtime of the associated code block
+		std::chrono::system_clock::duration duration()const noexcept{
+			return end - start;
+		}
+
+		/// \brief true if the body or the log function throw an exception
+		bool failed()const noexcept{
+			return log_exception
+				|| body == body_state::failed_by_exception
+				|| body == body_state::catched_exception;
+		}
+	};
+
+
+	/// \brief A complete unformatted log record
+	struct log_record{
+		/// \brief Meta data of the record
+		record_info info;
+
+		/// \brief The message text
+		std::string_view message;
+
+		/// \brief Exception throw in body function
+		std::exception_ptr body_exception;
+
+		/// \brief Exception throw in log function
+		std::exception_ptr log_exception;
+	};
+
+
+}
+
+
+#endif
@@ -0,0 +1,119 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__retain__hpp_INCLUDED_
+#define _logsys__retain__hpp_INCLUDED_
+
+#include "stdlogb.hpp"
+#include "record_info.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <string_view>
+
+
+namespace logsys{
+
+
+	namespace detail{
+
+
+		/// \brief Open a retention scope in the calling thread
+		///
+		/// \return Mark to pass to retention_end()
+		[[gnu::visibility("default")]]
+		std::size_t retention_begin()noexcept;
+
+		/// \brief Close the innermost retention scope of the calling thread
+		///
+		/// If the scope failed, its records are output. If it is nested in
+		/// another scope, they are handed over to the enclosing scope
+		/// instead. Otherwise they are discarded.
+		[[gnu::visibility("default")]]
+		void retention_end(std::size_t mark, bool failed)noexcept;
+
+		/// \brief Append a record to the innermost retention scope
+		///
+		/// The message is stored unformatted.
+		///
+		/// \return false if no retention scope is open in the calling thread
+		[[gnu::visibility("default")]]
+		bool retain(
+			record_info const& info,
+			std::string_view message,
+			std::exception_ptr body_exception,
+			std::exception_ptr log_exception
+		);
+
+
+	}
+
+
+	/// \brief Dynamic log that retains the records of its body
+	///
+	/// All stdlogb records created while the body is executed are kept in a
+	/// per thread arena. They are output only if the body throws, otherwise
+	/// they are discarded. The own record is output in both cases.
+	///
+	/// ```
+	/// logsys::log([&](logsys::stdlogr& log){ log << "request " << id; },
+	///     [&]{ handle(request); });
+	/// ```
+	class stdlogr: public stdlogb{
+	public:
+		/// \brief Construct a new derived log and open a retention scope
+		stdlogr()noexcept
+			: mark_(detail::retention_begin()) {}
+
+		stdlogr(stdlogr const&) = delete;
+
+		stdlogr& operator=(stdlogr const&) = delete;
+
+		/// \brief Close the retention scope if exec() was not called
+		~stdlogr(){
+			close();
+		}
+
+
+		/// \brief Mark the retention scope as failed
+		void set_body_exception(std::exception_ptr error, bool rethrow)noexcept{
+			failed_ = true;
+			stdlogb::set_body_exception(error, rethrow);
+		}
+
+		/// \brief Close the retention scope and output the own record
+		void exec()noexcept{
+			close();
+			stdlogb::exec();
+		}
+
+
+	private:
+		/// \brief Close the retention scope once
+		void close()noexcept{
+			if(!open_) return;
+			open_ = false;
+			detail::retention_end(mark_, failed_);
+		}
+
+
+		/// \brief Mark of the retention scope
+		std::size_t const mark_;
+
+		/// \brief true until the retention scope is closed
+		bool open_ = true;
+
+		/// \brief true if the body did throw
+		bool failed_ = false;
+	};
+
+
+}
+
+
+#endif
@@ -0,0 +1,264 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__rtlog__hpp_INCLUDED_
+#define _logsys__rtlog__hpp_INCLUDED_
+
+#include "record_info.hpp"
+#include "format.hpp"
+#include "stdlog_policy.hpp"
+#include "detail/page_buffer.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <string_view>
+#include <type_traits>
+
+
+namespace logsys{
+
+
+	/// \brief Options of a real time thread's ring
+	struct rtlog_options{
+		/// \brief Minimal count of records in the ring
+		std::size_t capacity = 256;
+
+		/// \brief Page type of the ring
+		huge_pages pages = huge_pages::none;
+
+		/// \brief Lock the ring in RAM by mlock()
+		bool lock_memory = false;
+	};
+
+	/// \brief Counters of the real time logging
+	struct rtlog_counters{
+		/// \brief Records stored in a ring
+		std::size_t posted = 0;
+
+		/// \brief Records lost because the ring of the thread was full
+		std::size_t dropped_full = 0;
+
+		/// \brief Records lost because the thread had no ring
+		std::size_t dropped_unprepared = 0;
+
+		/// \brief Records output by flush_rtlog()
+		std::size_t written = 0;
+
+		/// \brief Memory of all rings
+		std::size_t ring_bytes = 0;
+	};
+
+
+	/// \brief Create the ring of the calling thread
+	///
+	/// Must be called by every thread that uses rtlog before its real time
+	/// part starts, rtlog never allocates a ring. The memory is prefaulted.
+	/// Calling it again replaces the ring, records still queued in the old
+	/// one are output by the next flush_rtlog().
+	///
+	/// \throw std::bad_alloc
+	[[gnu::visibility("default")]]
+	void prepare_rt_thread(rtlog_options const& options = rtlog_options());
+
+	/// \brief Output the queued records of all rings to std::clog
+	///
+	/// Records are formatted like stdlog lines and output in the order of
+	/// time. Must not be called by a real time thread.
+	///
+	/// \return Count of output records
+	[[gnu::visibility("default")]]
+	std::size_t flush_rtlog()noexcept;
+
+	/// \brief Start a thread that calls flush_rtlog() every interval
+	///
+	/// If the writer is running already, only the interval is replaced.
+	[[gnu::visibility("default")]]
+	void start_rtlog_writer(
+		std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+	/// \brief Stop the writer thread and output the remaining records
+	///
+	/// Called automatically on program exit.
+	[[gnu::visibility("default")]]
+	void stop_rtlog_writer()noexcept;
+
+	/// \brief Get the counters of the real time logging
+	[[gnu::visibility("default")]]
+	rtlog_counters rtlog_statistics()noexcept;
+
+
+	namespace detail{
+
+
+		/// \brief Maximal message length of rtlog
+		constexpr std::size_t rt_text_size = 192;
+
+		/// \brief true if rtlog can output T without allocation
+		template < typename T >
+		constexpr bool is_rt_insertable_v =
+			std::is_arithmetic_v< T > ||
+			std::is_convertible_v< T const&, char const* > ||
+			std::is_convertible_v< T const&, std::string_view >;
+
+		/// \brief Copy a record into the ring of the calling thread
+		///
+		/// Wait-free, no allocation, no lock and no system call.
+		///
+		/// \return false if the record was dropped, because the thread has
+		///         no ring or the ring is full
+		[[gnu::visibility("default")]]
+		bool rt_post(
+			record_info const& info,
+			std::string_view message,
+			bool truncated,
+			std::exception_ptr const& body_exception,
+			std::exception_ptr const& log_exception)noexcept;
+
+
+	}
+
+
+	/// \brief A timed log type for real time threads
+	///
+	/// The message is collected in a fixed size buffer, longer text is
+	/// truncated. exec() copies the record into the preallocated ring of
+	/// the calling thread (see prepare_rt_thread()), the line is formatted
+	/// and output by flush_rtlog() on another thread. Only strings,
+	/// characters, bools and numbers can be output, so neither a log call
+	/// nor exec() allocates memory, locks a mutex or calls the system.
+	///
+	/// The first call of every log call site registers the site, so it
+	/// should happen before the real time part, too.
+	class rtlog{
+	private:
+		/// \brief Info about the body
+		using body = body_state;
+
+	public:
+		/// \brief Save start time
+		rtlog()noexcept:
+			id_(per_thread_id::next()),
+			start_(std::chrono::system_clock::now()) {}
+
+		/// \brief Save end time
+		void body_finished()noexcept{
+			end_ = std::chrono::system_clock::now();
+			body_ = body::exists;
+		}
+
+		/// \brief Save body exception
+		void set_body_exception(std::exception_ptr error, bool rethrow)noexcept{
+			body_exception_ = error;
+			if(rethrow){
+				body_ = body::failed_by_exception;
+			}else{
+				body_ = body::catched_exception;
+			}
+		}
+
+		/// \brief Save log exception
+		void set_log_exception(std::exception_ptr error)noexcept{
+			log_exception_ = error;
+		}
+
+		/// \brief Set the severity of the message
+		void set_level(logsys::level level)noexcept{
+			level_ = level;
+		}
+
+		/// \brief Copy the record into the ring of the calling thread
+		void exec()const noexcept{
+			detail::rt_post(info(), buffer_.view(), buffer_.truncated(),
+				body_exception_, log_exception_);
+		}
+
+		/// \brief Output data into the message buffer
+		template < typename T >
+		friend rtlog& operator<<(rtlog& log, T&& data)noexcept{
+			static_assert(detail::is_rt_insertable_v<
+					std::remove_cv_t< std::remove_reference_t< T > > >,
+				"rtlog can only output strings, characters, bools and "
+				"numbers");
+			log.buffer_.insert(static_cast< T&& >(data));
+			return log;
+		}
+
+		/// \brief Output args into the `{}` placeholders of fmt
+		///
+		/// Without consteval fmt is checked at runtime. An invalid fmt is
+		/// output unformatted behind "INVALID FORMAT STRING: ", nothing is
+		/// thrown.
+		template < typename ... Args >
+		rtlog& format(
+			nothrow_format_string< sizeof...(Args) > fmt,
+			Args&& ... args
+		)noexcept{
+			if(!fmt.valid()){
+				buffer_.append("INVALID FORMAT STRING: ");
+				buffer_.append(fmt.get());
+				return *this;
+			}
+
+			detail::format_parts(fmt.get(),
+				[this](std::string_view text){ buffer_.append(text); },
+				[this](auto&& arg){
+					*this << static_cast< decltype(arg)&& >(arg);
+				},
+				static_cast< Args&& >(args) ...);
+			return *this;
+		}
+
+		/// \brief Set the severity of the message
+		friend rtlog& operator<<(rtlog& log, logsys::level level)noexcept{
+			log.set_level(level);
+			return log;
+		}
+
+		/// \brief Meta data of the log message
+		record_info info()const noexcept{
+			return record_info{id_, start_, end_, body_,
+				static_cast< bool >(log_exception_), level_};
+		}
+
+		/// \brief The message text
+		std::string_view message()const noexcept{
+			return buffer_.view();
+		}
+
+	private:
+		/// \brief The message text
+		inline_buffer< detail::rt_text_size > buffer_;
+
+		/// \brief The body indicator
+		body body_ = body::none;
+
+		/// \brief Severity of the message
+		logsys::level level_ = logsys::level::info;
+
+		/// \brief Exception throw in body function
+		std::exception_ptr body_exception_ = nullptr;
+
+		/// \brief Exception throw in log function
+		std::exception_ptr log_exception_ = nullptr;
+
+		/// \brief The unique ID of this log message
+		std::size_t id_;
+
+		/// \brief Time point before associated code block is executed
+		std::chrono::system_clock::time_point start_;
+
+		/// \brief Time point after associated code block is executed
+		std::chrono::system_clock::time_point end_;
+	};
+
+
+}
+
+
+#endif
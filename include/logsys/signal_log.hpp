@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__signal_log__hpp_INCLUDED_
+#define _logsys__signal_log__hpp_INCLUDED_
+
+#include "rtlog.hpp"
+
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+
+namespace logsys{
+
+
+	namespace detail{
+
+
+		/// \brief Maximal message length of signal_log
+		constexpr std::size_t signal_text_size = 256;
+
+		/// \brief Output a line with the current time and message by a
+		///        single write(2)
+		///
+		/// Async-signal-safe, errno is preserved.
+		///
+		/// \return false if write(2) failed
+		[[gnu::visibility("default")]]
+		bool signal_write(int fd, std::string_view message, bool truncated)
+			noexcept;
+
+		/// \brief Output a line of a record by a single write(2)
+		///
+		/// Async-signal-safe, errno is preserved. Exceptions are only
+		/// reported, not printed.
+		[[gnu::visibility("default")]]
+		bool signal_write_record(
+			int fd,
+			record_info const& info,
+			std::string_view message,
+			bool truncated)noexcept;
+
+
+	}
+
+
+	/// \brief Log args to the file descriptor fd from a signal handler
+	///
+	/// The message is formatted into a stack buffer and output with the
+	/// current time by a single write(2), longer text is truncated. Only
+	/// strings, characters, bools and numbers can be output. No lock,
+	/// allocation or thread local is used, so it can be called from signal
+	/// handlers and in the child after fork(). The time is printed in UTC,
+	/// because the local time zone can not be read async-signal-safe.
+	template < typename ... Args >
+	void signal_log_to(int fd, Args&& ... args)noexcept{
+		static_assert((detail::is_rt_insertable_v<
+				std::remove_cv_t< std::remove_reference_t< Args > > > && ...),
+			"signal_log can only output strings, characters, bools and "
+			"numbers");
+
+		inline_buffer< detail::signal_text_size > buffer;
+		(buffer.insert(static_cast< Args&& >(args)), ...);
+		detail::signal_write(fd, buffer.view(), buffer.truncated());
+	}
+
+	/// \brief Log args to stderr from a signal handler
+	///
+	/// See signal_log_to().
+	template < typename ... Args >
+	void signal_log(Args&& ... args)noexcept{
+		signal_log_to(2, static_cast< Args&& >(args) ...);
+	}
+
+	/// \brief Output the queued records of all rtlog rings to fd
+	///
+	/// Async-signal-safe variant of flush_rtlog() for crash handlers. Every
+	/// record is output by a single write(2). Does nothing if another
+	/// thread or the interrupted code is flushing at the moment. The
+	/// exceptions of the records are only reported and never released, so
+	/// use it only if the process ends afterwards.
+	///
+	/// \return Count of output records
+	[[gnu::visibility("default")]]
+	std::size_t flush_rtlog_from_signal(int fd = 2)noexcept;
+
+
+}
+
+
+#endif
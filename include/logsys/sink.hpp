@@ -0,0 +1,234 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__sink__hpp_INCLUDED_
+#define _logsys__sink__hpp_INCLUDED_
+
+#include "record_info.hpp"
+
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+namespace logsys{
+
+
+	/// \brief A formatted log line, shared by all sinks of a record
+	using line_ptr = std::shared_ptr< std::string const >;
+
+
+	/// \brief Base class for log destinations
+	class [[gnu::visibility("default")]] sink{
+	public:
+		/// \brief Destructor
+		virtual ~sink()noexcept{}
+
+
+		/// \brief Decide by the meta data whether the record is wanted
+		///
+		/// Called before the line is formatted.
+		virtual bool accept(record_info const&)const noexcept{
+			return true;
+		}
+
+		/// \brief false if write() doesn't need the formatted line
+		///
+		/// If no accepting sink needs the line, it is never formatted.
+		virtual bool needs_line()const noexcept{
+			return true;
+		}
+
+		/// \brief Output an accepted record
+		///
+		/// line is empty if no accepting sink needs it.
+		virtual void write(
+			record_info const& info,
+			line_ptr const& line
+		)noexcept = 0;
+	};
+
+
+	/// \brief Immutable list of sinks
+	class [[gnu::visibility("default")]] sink_list{
+	public:
+		/// \brief Empty list
+		sink_list() = default;
+
+		/// \brief List of the given sinks
+		explicit sink_list(std::vector< std::shared_ptr< sink > > sinks)
+			: sinks_(std::move(sinks)) {}
+
+
+		/// \brief Get the sinks
+		std::vector< std::shared_ptr< sink > > const& sinks()const noexcept{
+			return sinks_;
+		}
+
+		/// \brief Output a record to all accepting sinks
+		///
+		/// `render()` is called at most once, and only if an accepting sink
+		/// needs the formatted line.
+		template < typename Render >
+		void dispatch(record_info const& info, Render&& render)const{
+			line_ptr line;
+			for(auto const& s: sinks_){
+				if(!s->accept(info)) continue;
+
+				if(!line && s->needs_line()){
+					line = std::make_shared< std::string const >(render());
+				}
+
+				s->write(info, line);
+			}
+		}
+
+
+	private:
+		/// \brief The sinks
+		std::vector< std::shared_ptr< sink > > sinks_;
+	};
+
+
+	/// \brief Get the current global sinks
+	///
+	/// By default this is one ostream_sink to std::clog. Shortcut for
+	/// `config()->sinks`. (See config.hpp.)
+	[[gnu::visibility("default")]]
+	sink_list sinks();
+
+	/// \brief Add a sink to the global sinks
+	[[gnu::visibility("default")]]
+	void add_sink(std::shared_ptr< sink > s);
+
+	/// \brief Remove a sink from the global sinks
+	[[gnu::visibility("default")]]
+	void remove_sink(sink const* s);
+
+	/// \brief Remove all global sinks
+	[[gnu::visibility("default")]]
+	void clear_sinks();
+
+
+	/// \brief Write lines to an output stream
+	class [[gnu::visibility("default")]] ostream_sink: public sink{
+	public:
+		/// \brief Constructor
+		///
+		/// The stream must outlive the sink.
+		explicit ostream_sink(std::ostream& os)noexcept
+			: os_(os) {}
+
+		/// \brief Write line to the stream
+		void write(record_info const&, line_ptr const& line)noexcept override;
+
+	private:
+		/// \brief Serializes writes from different threads
+		std::mutex mutex_;
+
+		/// \brief The output stream
+		std::ostream& os_;
+	};
+
+
+	namespace detail{
+
+
+		/// \brief Base class of file_sink that is initialized before the
+		///        ostream_sink base
+		struct file_holder{
+			/// \brief The output file
+			std::ofstream file;
+		};
+
+
+	}
+
+
+	/// \brief Write lines to a file
+	class [[gnu::visibility("default")]] file_sink
+		: private detail::file_holder
+		, public ostream_sink
+	{
+	public:
+		/// \brief Open file in append mode
+		///
+		/// \throw std::runtime_error if the file can not be opened
+		explicit file_sink(std::string const& filename);
+	};
+
+
+	/// \brief Keep the last lines in memory as flight recorder
+	class [[gnu::visibility("default")]] ring_sink: public sink{
+	public:
+		/// \brief Constructor
+		explicit ring_sink(std::size_t capacity)
+			: capacity_(capacity) {}
+
+		/// \brief Store line, drop the oldest one if full
+		void write(record_info const&, line_ptr const& line)noexcept override;
+
+		/// \brief Get the stored lines, oldest first
+		std::vector< line_ptr > lines()const;
+
+	private:
+		/// \brief Guards lines_
+		mutable std::mutex mutex_;
+
+		/// \brief Maximum number of stored lines
+		std::size_t const capacity_;
+
+		/// \brief The stored lines
+		std::deque< line_ptr > lines_;
+	};
+
+
+	/// \brief Count records without formatting them
+	class [[gnu::visibility("default")]] counter_sink: public sink{
+	public:
+		/// \brief Counter sink never needs the line
+		bool needs_line()const noexcept override{
+			return false;
+		}
+
+		/// \brief Count the record
+		void write(record_info const& info, line_ptr const&)noexcept override{
+			records_.fetch_add(1, std::memory_order_relaxed);
+			if(info.failed()){
+				failures_.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		/// \brief Number of counted records
+		std::size_t records()const noexcept{
+			return records_.load(std::memory_order_relaxed);
+		}
+
+		/// \brief Number of counted records with an exception
+		std::size_t failures()const noexcept{
+			return failures_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		/// \brief Number of counted records
+		std::atomic< std::size_t > records_{0};
+
+		/// \brief Number of counted records with an exception
+		std::atomic< std::size_t > failures_{0};
+	};
+
+
+}
+
+
+#endif
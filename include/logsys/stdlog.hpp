@@ -9,40 +9,70 @@
 #ifndef _logsys__stdlog__hpp_INCLUDED_
 #define _logsys__stdlog__hpp_INCLUDED_
 
+#include "record_info.hpp"
+#include "format.hpp"
+#include "stdlog_policy.hpp"
+
 #include <io_tools/time_to_string.hpp>
 #include <io_tools/mask_non_print.hpp>
 
 #include <boost/type_index.hpp>
 
+#include <algorithm>
 #include <atomic>
+#include <cctype>
 #include <iomanip>
 #include <cassert>
+#include <string_view>
 
 
 namespace logsys{
 
 
 	/// \brief A timed log type
-	class stdlog{
+	///
+	/// All parts are policies, so no virtual function is called and the
+	/// whole log call can be inlined. (See stdlog_policy.hpp for the
+	/// requirements.)
+	///
+	/// \tparam Buffer Collects the message text, a protected base class
+	/// \tparam Clock Provides start and end time
+	/// \tparam IdSource Provides the unique ID
+	/// \tparam Sink Outputs the formatted line
+	template <
+		typename Buffer,
+		typename Clock,
+		typename IdSource,
+		typename Sink >
+	class basic_stdlog: protected Buffer{
 	private:
 		/// \brief Info about the body
-		enum body{
-			none,
-			exists,
-			failed_by_exception,
-			catched_exception,
-		};
+		using body = body_state;
 
 	public:
 		/// \brief Save start time
-		stdlog()noexcept:
+		basic_stdlog()noexcept:
 			id_(unique_id()),
-			start_(std::chrono::system_clock::now())
-			{ os_ << std::boolalpha; }
+			start_(Clock::now()) {}
+
+		/// \brief Restore a log with body state from its meta data
+		///
+		/// Used to execute a log function after the body, e.g. on the
+		/// backend thread.
+		basic_stdlog(
+			record_info const& info,
+			std::exception_ptr body_exception
+		)noexcept:
+			body_(info.body),
+			level_(info.level),
+			body_exception_(body_exception),
+			id_(info.id),
+			start_(info.start),
+			end_(info.end) {}
 
 		/// \brief Output ID and time block
 		void body_finished()noexcept{
-			end_ = std::chrono::system_clock::now();
+			end_ = Clock::now();
 			body_ = body::exists;
 		}
 
@@ -63,9 +93,14 @@ namespace logsys{
 			log_exception_ = error;
 		}
 
-		/// \brief Output the combinded message to std::log
+		/// \brief Set the severity of the message
+		void set_level(logsys::level level)noexcept{
+			level_ = level;
+		}
+
+		/// \brief Output the combinded message to the Sink
 		void exec()const noexcept try{
-			std::clog << make_log_line();
+			Sink::write(info(), make_log_line());
 		}catch(std::exception const& e){
 			std::cerr << "terminate with exception in stdlog.exec(): "
 				<< e.what() << std::endl;
@@ -76,52 +111,98 @@ namespace logsys{
 			std::terminate();
 		}
 
-		/// \brief Forward every output to the message stream
+		/// \brief Forward every output to the message buffer
 		template < typename T >
-		friend stdlog& operator<<(stdlog& log, T&& data){
-			using type = std::remove_cv_t< std::remove_reference_t< T > >;
-			if constexpr(
-				std::is_same_v< type, char > ||
-				std::is_same_v< type, signed char > ||
-				std::is_same_v< type, unsigned char >
-			){
-				log.os_ << static_cast< int >(data);
-			}else{
-				log.os_ << static_cast< T&& >(data);
-			}
+		friend basic_stdlog& operator<<(basic_stdlog& log, T&& data){
+			log.buffer().insert(static_cast< T&& >(data));
 			return log;
 		}
 
-		std::string make_log_line()const{
-			std::ostringstream os;
+		/// \brief Output args into the `{}` placeholders of fmt
+		///
+		/// Every argument is output as by operator<<. `{{` and `}}` output
+		/// a single brace.
+		template < typename ... Args >
+		basic_stdlog& format(
+			format_string< sizeof...(Args) > fmt,
+			Args&& ... args
+		){
+			detail::format_parts(fmt.get(),
+				[this](std::string_view text){ buffer().append(text); },
+				[this](auto&& arg){
+					*this << static_cast< decltype(arg)&& >(arg);
+				},
+				static_cast< Args&& >(args) ...);
+			return *this;
+		}
+
+		/// \brief Set the severity of the message
+		friend basic_stdlog& operator<<(
+			basic_stdlog& log,
+			logsys::level level
+		)noexcept{
+			log.set_level(level);
+			return log;
+		}
 
-			os << std::setfill('0') << std::setw(6) << id_ << ' ';
+		/// \brief Meta data of the log message
+		record_info info()const noexcept{
+			return record_info{id_, start_, end_, body_,
+				static_cast< bool >(log_exception_), level_};
+		}
 
-			io_tools::time_to_string(os, start_);
+		/// \brief Format the log message as line
+		std::string make_log_line()const{
+			return make_log_line(info(), buffer().str(),
+				body_exception_, log_exception_);
+		}
 
-			if(body_ != body::none){
-				os << " ( " << std::setfill(' ') << std::setprecision(3)
-					<< std::setw(12)
-					<< std::chrono::duration< double, std::milli >(
-							end_ - start_
-						).count() << "ms ) ";
+		/// \brief Format a log message from its parts as line
+		static std::string make_log_line(
+			record_info const& info,
+			std::string_view message,
+			std::exception_ptr body_exception,
+			std::exception_ptr log_exception
+		){
+			std::ostringstream os;
+
+			write_padded(os, detail::number_chars< std::size_t >(info.id),
+				'0', 6);
+			os << ' ';
+
+			io_tools::time_to_string(os, info.start);
+
+			if(info.body != body::none){
+				auto const ms = std::chrono::duration< double, std::milli >(
+						info.end - info.start
+					).count();
+				os << " ( ";
+				detail::number_chars< double > text(ms, 3);
+				if(text.valid()){
+					write_padded(os, text, ' ', 12);
+				}else{
+					os << std::setfill(' ') << std::setprecision(3)
+						<< std::setw(12) << ms;
+				}
+				os << "ms ) ";
 			}else{
 				os << " ( no content     ) ";
 			}
 
-			if(log_exception_){
+			if(log_exception){
 				os << "LOG EXCEPTION CATCHED: ";
 
-				print_exception(os, log_exception_);
+				print_exception(os, log_exception);
 
-				os << "; Probably incomplete log message: '"
-					<< io_tools::mask_non_print(os_.str()) << "'";
+				os << "; Probably incomplete log message: '";
+				write_masked(os, message);
+				os << "'";
 			}else{
-				os << io_tools::mask_non_print(os_.str());
+				write_masked(os, message);
 			}
 
-			if(body_exception_){
-				switch(body_){
+			if(body_exception){
+				switch(info.body){
 					case body::catched_exception:
 						os << " (BODY EXCEPTION CATCHED: ";
 						break;
@@ -132,7 +213,7 @@ namespace logsys{
 						assert(false);
 				}
 
-				print_exception(os, body_exception_);
+				print_exception(os, body_exception);
 
 				os << ')';
 			}
@@ -145,8 +226,48 @@ namespace logsys{
 	protected:
 		/// \brief Get a unique id for every message
 		static std::size_t unique_id()noexcept{
-			static std::atomic< std::size_t > next_id(0);
-			return next_id++;
+			return IdSource::next();
+		}
+
+		/// \brief The message text
+		Buffer& buffer()noexcept{
+			return *this;
+		}
+
+		/// \brief The message text
+		Buffer const& buffer()const noexcept{
+			return *this;
+		}
+
+		/// \brief Output text right aligned in a field of width characters
+		template < typename T >
+		static void write_padded(
+			std::ostream& os,
+			detail::number_chars< T > const& text,
+			char fill,
+			std::size_t width
+		){
+			auto const view = text.view();
+			for(auto i = view.size(); i < width; ++i){
+				os.put(fill);
+			}
+			os.write(view.data(), static_cast< std::streamsize >(view.size()));
+		}
+
+		/// \brief Output text, non printable characters masked
+		///
+		/// Printable text is written directly, without a copy.
+		static void write_masked(std::ostream& os, std::string_view text){
+			auto const printable = std::all_of(text.begin(), text.end(),
+				[](char c){
+					return std::isprint(static_cast< unsigned char >(c)) != 0;
+				});
+			if(printable){
+				os.write(text.data(),
+					static_cast< std::streamsize >(text.size()));
+			}else{
+				os << io_tools::mask_non_print(std::string(text));
+			}
 		}
 
 		static void print_exception(
@@ -175,12 +296,12 @@ namespace logsys{
 		}
 
 
-		/// \brief The message stream
-		std::ostringstream os_;
-
 		/// \brief The body indicator
 		body body_ = body::none;
 
+		/// \brief Severity of the message
+		logsys::level level_ = logsys::level::info;
+
 		/// \brief Exception throw in body function
 		std::exception_ptr body_exception_ = nullptr;
 
@@ -198,6 +319,25 @@ namespace logsys{
 	};
 
 
+	/// \brief The standard timed log type
+	///
+	/// A class instead of an alias of basic_stdlog, so it can be forward
+	/// declared and derived classes keep the protected members of earlier
+	/// versions.
+	class stdlog: public basic_stdlog< stream_buffer,
+		std::chrono::system_clock, global_id, clog_sink >{
+	public:
+		using basic_stdlog::basic_stdlog;
+
+		/// \brief Forward every output to the message buffer
+		template < typename T >
+		friend stdlog& operator<<(stdlog& log, T&& data){
+			static_cast< basic_stdlog& >(log) << static_cast< T&& >(data);
+			return log;
+		}
+	};
+
+
 }
 
 
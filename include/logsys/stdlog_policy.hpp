@@ -0,0 +1,524 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__stdlog_policy__hpp_INCLUDED_
+#define _logsys__stdlog_policy__hpp_INCLUDED_
+
+#include "record_info.hpp"
+#include "detail/append.hpp"
+#include "detail/arena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+
+namespace logsys{
+
+
+	/// \brief Buffer policy of basic_stdlog: a std::ostringstream
+	///
+	/// A Buffer is nothrow default constructible and provides:
+	/// - `insert(T&& data)` to output data as by `std::ostream`
+	/// - `append(std::string_view text)` to output text unchanged
+	/// - `str()const` to get the message text as `std::string`
+	///
+	/// Characters are output as integers, bools as text.
+	class stream_buffer{
+	public:
+		/// \brief Enable std::boolalpha
+		stream_buffer()noexcept{
+			os_ << std::boolalpha;
+		}
+
+		/// \brief Output data, numbers via std::to_chars
+		template < typename T >
+		void insert(T&& data){
+			using type = std::remove_cv_t< std::remove_reference_t< T > >;
+			if constexpr(detail::is_char_v< type >){
+				detail::write_number(os_, static_cast< int >(data));
+			}else if constexpr(detail::is_number_v< type >){
+				detail::write_number(os_, data);
+			}else{
+				os_ << static_cast< T&& >(data);
+			}
+		}
+
+		/// \brief Output text unchanged
+		void append(std::string_view text){
+			os_.write(text.data(), static_cast< std::streamsize >(text.size()));
+		}
+
+		/// \brief The message text
+		std::string str()const{
+			return os_.str();
+		}
+
+	protected:
+		/// \brief The message stream
+		///
+		/// Protected, so stdlog provides it to derived classes as in
+		/// earlier versions.
+		std::ostringstream os_;
+	};
+
+
+	namespace detail{
+
+
+		/// \brief Output data by buffer.append(std::string_view)
+		///
+		/// No allocation for strings, characters, bools and numbers. Other
+		/// types are formatted by a temporary std::ostringstream.
+		template < typename Buffer, typename T >
+		void insert_as_text(Buffer& buffer, T&& data){
+			using type = std::remove_cv_t< std::remove_reference_t< T > >;
+			if constexpr(is_char_v< type >){
+				buffer.append(number_chars< int >(data).view());
+			}else if constexpr(std::is_same_v< type, bool >){
+				buffer.append(data ? "true" : "false");
+			}else if constexpr(std::is_integral_v< type >){
+				buffer.append(number_chars< type >(data).view());
+			}else if constexpr(std::is_floating_point_v< type >){
+				number_chars< type > text(data, 6);
+				if(text.valid()){
+					buffer.append(text.view());
+				}else{
+					std::ostringstream os;
+					os << data;
+					buffer.append(os.str());
+				}
+			}else if constexpr(std::is_convertible_v< T&&, char const* >){
+				char const* const text = data;
+				if(text != nullptr) buffer.append(text);
+			}else if constexpr(std::is_convertible_v< T&&, std::string_view >){
+				buffer.append(std::string_view(data));
+			}else{
+				std::ostringstream os;
+				os << std::boolalpha << static_cast< T&& >(data);
+				buffer.append(os.str());
+			}
+		}
+
+
+	}
+
+
+	/// \brief Buffer policy of basic_stdlog: a fixed size array
+	///
+	/// Data is output as by detail::insert_as_text(). Text that does not fit
+	/// is truncated.
+	template < std::size_t Capacity >
+	class inline_buffer{
+	public:
+		/// \brief Output data
+		template < typename T >
+		void insert(T&& data){
+			detail::insert_as_text(*this, static_cast< T&& >(data));
+		}
+
+		/// \brief Output text, truncate it if necessary
+		void append(std::string_view text)noexcept{
+			auto const count = std::min(text.size(), Capacity - size_);
+			std::memcpy(data_ + size_, text.data(), count);
+			size_ += count;
+			truncated_ = truncated_ || count < text.size();
+		}
+
+		/// \brief The message text
+		std::string str()const{
+			return std::string(view());
+		}
+
+		/// \brief The message text
+		std::string_view view()const noexcept{
+			return std::string_view(data_, size_);
+		}
+
+		/// \brief true if text was lost
+		bool truncated()const noexcept{
+			return truncated_;
+		}
+
+	private:
+		/// \brief The text
+		char data_[Capacity];
+
+		/// \brief Size of the text
+		std::size_t size_ = 0;
+
+		/// \brief true if text was lost
+		bool truncated_ = false;
+	};
+
+
+	/// \brief Buffer policy of basic_stdlog: a std::string and a lazy stream
+	///
+	/// Construction does nothing. Strings, characters, bools and numbers
+	/// are output as by detail::insert_as_text() into a std::string. A
+	/// std::ostringstream is created by the first insertion of any other
+	/// type and continues the text. All following output goes through the
+	/// stream, so manipulators like std::hex work as by stream_buffer.
+	class lazy_stream_buffer{
+	public:
+		/// \brief Output data, create the stream if necessary
+		template < typename T >
+		void insert(T&& data){
+			using type = std::remove_cv_t< std::remove_reference_t< T > >;
+			if(os_){
+				if constexpr(detail::is_char_v< type >){
+					detail::write_number(*os_, static_cast< int >(data));
+				}else if constexpr(detail::is_number_v< type >){
+					detail::write_number(*os_, data);
+				}else{
+					*os_ << static_cast< T&& >(data);
+				}
+			}else if constexpr(std::is_floating_point_v< type >){
+				if(!detail::append_float(text_, data)){
+					stream() << data;
+				}
+			}else if constexpr(
+				std::is_arithmetic_v< type > ||
+				std::is_convertible_v< T&&, char const* > ||
+				std::is_convertible_v< T&&, std::string_view >
+			){
+				detail::insert_as_text(*this, static_cast< T&& >(data));
+			}else{
+				stream() << static_cast< T&& >(data);
+			}
+		}
+
+		/// \brief Output text unchanged
+		void append(std::string_view text){
+			if(os_){
+				os_->write(text.data(),
+					static_cast< std::streamsize >(text.size()));
+			}else{
+				text_.append(text);
+			}
+		}
+
+		/// \brief The message text
+		std::string str()const{
+			return os_ ? os_->str() : text_;
+		}
+
+	private:
+		/// \brief Create the stream, it continues the message text
+		std::ostream& stream(){
+			os_ = std::make_unique< std::ostringstream >(
+				std::move(text_), std::ios_base::ate);
+			*os_ << std::boolalpha;
+			return *os_;
+		}
+
+
+		/// \brief The message text until a stream is needed
+		std::string text_;
+
+		/// \brief The message stream, created on first need
+		std::unique_ptr< std::ostringstream > os_;
+	};
+
+
+	/// \brief Buffer policy of basic_stdlog: memory of the thread's arena
+	///
+	/// The text is stored in the detail::message_arena of the constructing
+	/// thread, a per thread bump allocator. Growing text is never copied,
+	/// a message that doesn't fit into the current chunk continues in the
+	/// next one. A destroyed buffer returns its segments that are on top of
+	/// the arena, so nested messages reuse the memory even while an outer
+	/// message lives. Collecting the text only allocates while the arena
+	/// grows to its working size.
+	///
+	/// str() still copies the text into a std::string, and basic_stdlog
+	/// formats the line by a std::ostringstream, since io_tools and the
+	/// Sink interface take std::string. So exec() allocates like with
+	/// every other buffer.
+	///
+	/// Data is output as by detail::insert_as_text(). The buffer must be
+	/// destroyed by the constructing thread.
+	class arena_buffer{
+	public:
+		/// \brief Register at the thread's arena
+		arena_buffer()noexcept:
+			arena_(detail::message_arena::local())
+		{
+			arena_.acquire();
+		}
+
+		arena_buffer(arena_buffer const&) = delete;
+
+		arena_buffer& operator=(arena_buffer const&) = delete;
+
+		/// \brief Release the memory to the arena
+		~arena_buffer(){
+			// newest segment first, as long as they are on top
+			for(auto i = last_; i != nullptr; i = i->previous){
+				if(!arena_.pop(*i)) break;
+			}
+			arena_.release();
+		}
+
+
+		/// \brief Output data
+		template < typename T >
+		void insert(T&& data){
+			detail::insert_as_text(*this, static_cast< T&& >(data));
+		}
+
+		/// \brief Output text unchanged
+		void append(std::string_view text){
+			while(!text.empty()){
+				if(last_ != nullptr){
+					auto const count = arena_.extend(*last_, text);
+					text.remove_prefix(count);
+					size_ += count;
+					if(text.empty()) break;
+				}
+
+				auto const segment = arena_.new_segment();
+				segment->previous = last_;
+				(last_ != nullptr ? last_->next : first_) = segment;
+				last_ = segment;
+			}
+		}
+
+		/// \brief The message text
+		///
+		/// Allocates the returned string.
+		std::string str()const{
+			std::string result;
+			result.reserve(size_);
+			for(auto i = first_; i != nullptr; i = i->next){
+				result.append(i->data(), i->size);
+			}
+			return result;
+		}
+
+		/// \brief Length of the message text
+		std::size_t size()const noexcept{
+			return size_;
+		}
+
+	private:
+		/// \brief Arena of the constructing thread
+		detail::message_arena& arena_;
+
+		/// \brief First piece of text
+		detail::arena_segment* first_ = nullptr;
+
+		/// \brief Last piece of text
+		detail::arena_segment* last_ = nullptr;
+
+		/// \brief Length of the text
+		std::size_t size_ = 0;
+	};
+
+
+
+	namespace detail{
+
+
+		/// \brief Memory resource of the calling thread, nullptr for default
+		inline std::pmr::memory_resource*& thread_memory_resource()noexcept{
+			thread_local std::pmr::memory_resource* resource = nullptr;
+			return resource;
+		}
+
+
+	}
+
+
+	/// \brief Memory resource for pmr_buffer's of the calling thread
+	///
+	/// std::pmr::get_default_resource() if no memory_resource_scope is
+	/// active.
+	inline std::pmr::memory_resource* log_memory_resource()noexcept{
+		auto const resource = detail::thread_memory_resource();
+		return resource != nullptr ? resource : std::pmr::get_default_resource();
+	}
+
+	/// \brief Set the memory resource of the calling thread for its lifetime
+	///
+	/// Log objects must be nothrow default constructible, so the resource
+	/// can not be given to them directly. pmr_buffer takes it from here.
+	/// Scopes can be nested, the destructor restores the previous resource.
+	class memory_resource_scope{
+	public:
+		/// \brief Set resource as resource of the calling thread
+		explicit memory_resource_scope(std::pmr::memory_resource* resource)
+		noexcept:
+			old_(std::exchange(detail::thread_memory_resource(), resource)) {}
+
+		memory_resource_scope(memory_resource_scope const&) = delete;
+
+		memory_resource_scope& operator=(memory_resource_scope const&)
+			= delete;
+
+		/// \brief Restore the previous resource
+		~memory_resource_scope(){
+			detail::thread_memory_resource() = old_;
+		}
+
+	private:
+		/// \brief The previous resource
+		std::pmr::memory_resource* old_;
+	};
+
+
+	/// \brief Buffer policy of basic_stdlog: a std::pmr::string
+	///
+	/// The memory comes from the log_memory_resource() at construction
+	/// time. Data is output as by detail::insert_as_text().
+	class pmr_buffer{
+	public:
+		/// \brief Use the resource of the calling thread
+		pmr_buffer()noexcept:
+			text_(log_memory_resource()) {}
+
+
+		/// \brief Output data
+		template < typename T >
+		void insert(T&& data){
+			detail::insert_as_text(*this, static_cast< T&& >(data));
+		}
+
+		/// \brief Output text unchanged
+		void append(std::string_view text){
+			text_.append(text);
+		}
+
+		/// \brief The message text
+		std::string str()const{
+			return std::string(text_);
+		}
+
+		/// \brief The message text
+		std::string_view view()const noexcept{
+			return text_;
+		}
+
+		/// \brief The memory resource of the text
+		std::pmr::memory_resource* resource()const noexcept{
+			return text_.get_allocator().resource();
+		}
+
+	private:
+		/// \brief The text
+		std::pmr::string text_;
+	};
+
+
+	/// \brief IdSource policy of basic_stdlog: one global counter
+	///
+	/// An IdSource provides `static std::size_t next()noexcept`.
+	struct global_id{
+		/// \brief Get a unique id for every message
+		static std::size_t next()noexcept{
+			static std::atomic< std::size_t > next_id(0);
+			return next_id++;
+		}
+	};
+
+	namespace detail{
+
+
+		/// \brief Incremented in the child process after fork()
+		///
+		/// Done by the fork handlers of the library.
+		inline std::atomic< unsigned >& fork_generation()noexcept{
+			static std::atomic< unsigned > generation(0);
+			return generation;
+		}
+
+
+	}
+
+
+	/// \brief IdSource policy of basic_stdlog: counter per thread
+	///
+	/// The upper bits hold a number of the thread, the lower bits count the
+	/// messages of the thread. No shared cache line is written. After
+	/// fork() the thread of the child gets a new number and starts
+	/// counting from zero.
+	struct per_thread_id{
+		/// \brief Bits of the message counter
+		static constexpr std::size_t counter_bits =
+			sizeof(std::size_t) * 8 * 5 / 8;
+
+		/// \brief Get a unique id for every message
+		static std::size_t next()noexcept{
+			static std::atomic< std::size_t > next_thread(0);
+			thread_local std::size_t thread = next_thread++;
+			thread_local std::size_t counter = 0;
+			thread_local unsigned generation = 0;
+
+			auto const current =
+				detail::fork_generation().load(std::memory_order_relaxed);
+			if(generation != current){
+				generation = current;
+				thread = next_thread++;
+				counter = 0;
+			}
+
+			constexpr auto mask = (std::size_t(1) << counter_bits) - 1;
+			return (thread << counter_bits) | (counter++ & mask);
+		}
+	};
+
+
+	/// \brief Clock policy of basic_stdlog: a coarse system clock
+	///
+	/// A Clock provides
+	/// `static std::chrono::system_clock::time_point now()noexcept`, so
+	/// std::chrono::system_clock is a Clock itself. This one uses
+	/// CLOCK_REALTIME_COARSE where available, which is faster but has only
+	/// the resolution of the kernel tick.
+	struct coarse_system_clock{
+		/// \brief Current time
+		static std::chrono::system_clock::time_point now()noexcept{
+#ifdef CLOCK_REALTIME_COARSE
+			timespec ts;
+			if(clock_gettime(CLOCK_REALTIME_COARSE, &ts) == 0){
+				using namespace std::chrono;
+				return system_clock::time_point(duration_cast<
+					system_clock::duration >(
+						seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec)));
+			}
+#endif
+			return std::chrono::system_clock::now();
+		}
+	};
+
+
+	/// \brief Sink policy of basic_stdlog: std::clog
+	///
+	/// A Sink provides
+	/// `static void write(record_info const& info, std::string const& line)`.
+	struct clog_sink{
+		/// \brief Output line to std::clog
+		static void write(record_info const&, std::string const& line){
+			std::clog << line;
+		}
+	};
+
+
+}
+
+
+#endif
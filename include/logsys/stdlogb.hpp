@@ -9,6 +9,9 @@
 #ifndef _logsys__stdlogb__hpp_INCLUDED_
 #define _logsys__stdlogb__hpp_INCLUDED_
 
+#include "record_info.hpp"
+#include "format.hpp"
+
 #include <iostream>
 #include <memory>
 
@@ -32,28 +35,85 @@ namespace logsys{
 		/// \brief Called if log function throw an exception
 		virtual void set_log_exception(std::exception_ptr)noexcept{}
 
+		/// \brief Called if a level is inserted
+		virtual void set_level(level)noexcept{}
+
 		/// \brief Called after all work is done
 		///
 		/// Output your log message now.
 		virtual void exec()const noexcept{}
 
+		/// \brief Called once with the complete record by stdlogb_buffered
+		///
+		/// The default replays the record by the other virtual functions, the
+		/// times of the record are lost then. Override it to output the record
+		/// with one virtual call.
+		virtual void exec_record(log_record const& record)noexcept{
+			try{
+				append(record.message);
+			}catch(...){
+				set_log_exception(std::current_exception());
+			}
+
+			set_level(record.info.level);
+
+			if(record.info.body != body_state::none){
+				body_finished();
+			}
+
+			if(record.body_exception){
+				set_body_exception(record.body_exception,
+					record.info.body == body_state::failed_by_exception);
+			}
+
+			if(record.log_exception){
+				set_log_exception(record.log_exception);
+			}
+
+			exec();
+		}
+
+		/// \brief Called by format() with the complete formatted text
+		virtual void append(std::string_view text){
+			os().write(text.data(), static_cast< std::streamsize >(text.size()));
+		}
+
 
 		/// \brief Output operator overload
 		template < typename T >
 		friend stdlog_base& operator<<(stdlog_base& log, T&& data){
 			using type = std::remove_cv_t< std::remove_reference_t< T > >;
-			if constexpr(
-				std::is_same_v< type, char > ||
-				std::is_same_v< type, signed char > ||
-				std::is_same_v< type, unsigned char >
-			){
-				log.os() << static_cast< int >(data);
+			if constexpr(detail::is_char_v< type >){
+				detail::write_number(log.os(), static_cast< int >(data));
+			}else if constexpr(detail::is_number_v< type >){
+				detail::write_number(log.os(), data);
 			}else{
 				log.os() << static_cast< T&& >(data);
 			}
 			return log;
 		}
 
+		/// \brief Output args into the `{}` placeholders of fmt
+		///
+		/// The text is formatted completely and then passed by one call of
+		/// append().
+		template < typename ... Args >
+		stdlog_base& format(
+			format_string< sizeof...(Args) > fmt,
+			Args const& ... args
+		){
+			std::string text;
+			detail::format_to(text, fmt, args ...);
+			append(text);
+			return *this;
+		}
+
+		/// \brief Set the severity of the message
+		friend stdlog_base& operator<<(stdlog_base& log, level l)noexcept{
+			log.set_level(l);
+			return log;
+		}
+
 	protected:
 		/// \brief Provide an output stream for operator<<()
 		virtual std::ostream& os()noexcept = 0;
@@ -65,8 +125,8 @@ namespace logsys{
 	public:
 		/// \brief Create a stdlogb derived log object
 		///
-		/// Link against logsys/liblogsys.so and assign your log object creater
-		/// function to stdlogb_factory_object.
+		/// Link against logsys/liblogsys.so and set your log object creater
+		/// function as factory in the configuration. (See config.hpp.)
 		static std::unique_ptr< stdlog_base > factory()noexcept;
 
 
@@ -89,6 +149,11 @@ namespace logsys{
 			derived_->set_log_exception(error);
 		}
 
+		/// \brief Set the severity of the message
+		void set_level(level l)noexcept{
+			derived_->set_level(l);
+		}
+
 		/// \brief Called after all work is done
 		///
 		/// Output your log message now.
@@ -104,6 +169,16 @@ namespace logsys{
 			return log;
 		}
 
+		/// \copydoc stdlog_base::format()
+		template < typename ... Args >
+		stdlogb& format(
+			format_string< sizeof...(Args) > fmt,
+			Args const& ... args
+		){
+			derived_->format(fmt, args ...);
+			return *this;
+		}
+
 	protected:
 		/// \brief The actual log object
 		std::unique_ptr< stdlog_base > derived_;
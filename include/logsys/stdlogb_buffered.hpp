@@ -0,0 +1,48 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__stdlogb_buffered__hpp_INCLUDED_
+#define _logsys__stdlogb_buffered__hpp_INCLUDED_
+
+#include "stdlogb.hpp"
+#include "stdlogl.hpp"
+
+
+namespace logsys{
+
+
+	/// \brief Dynamic log with one virtual call per message
+	///
+	/// Like stdlogb, but ID, times, message text and exceptions are
+	/// collected locally without virtual calls. (See stdlogl.) The stdlogb
+	/// factory object is created in exec() and gets the complete record by
+	/// one call of stdlog_base::exec_record().
+	class stdlogb_buffered: public stdlogl{
+	public:
+		/// \brief Pass the record to a new stdlogb factory object
+		void exec()const noexcept try{
+			auto const derived = stdlogb::factory();
+			auto const message = buffer().str();
+			derived->exec_record(log_record{info(), message,
+				body_exception_, log_exception_});
+		}catch(std::exception const& e){
+			std::cerr << "terminate with exception in stdlogb_buffered.exec(): "
+				<< e.what() << std::endl;
+			std::terminate();
+		}catch(...){
+			std::cerr << "terminate with unknown exception in "
+				"stdlogb_buffered.exec()" << std::endl;
+			std::terminate();
+		}
+	};
+
+
+}
+
+
+#endif
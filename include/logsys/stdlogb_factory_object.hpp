@@ -19,6 +19,10 @@ namespace logsys{
 	class stdlog_base;
 
 	/// \brief Assign your log object maker to this variable
+	///
+	/// Used if the factory of the configuration is nullptr. Assigning it while
+	/// other threads log is a data race, set the factory by set_config()
+	/// instead. (See config.hpp.)
 	extern std::unique_ptr< stdlog_base >(*stdlogb_factory_object)()noexcept;
 
 
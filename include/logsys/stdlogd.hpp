@@ -11,6 +11,9 @@
 
 #include "stdlogb.hpp"
 #include "stdlog.hpp"
+#include "config.hpp"
+#include "coalesce.hpp"
+#include "retain.hpp"
 
 
 namespace logsys{
@@ -37,9 +40,53 @@ namespace logsys{
 			stdlog::set_log_exception(error);
 		}
 
-		/// \copydoc stdlog::exec()
-		void exec()const noexcept override{
-			stdlog::exec();
+		/// \copydoc stdlog::set_level()
+		void set_level(level l)noexcept override{
+			stdlog::set_level(l);
+		}
+
+		/// \brief Output the record to all accepting global sinks
+		///
+		/// Records below the configured thresholds are dropped before the
+		/// message text is copied. Inside of a stdlogr body, records are
+		/// retained. Duplicates are dropped if coalescing is enabled. The
+		/// line is formatted at most once and shared by all sinks.
+		void exec()const noexcept override try{
+			auto const c = config();
+			auto const meta = info();
+			if(!c->accept(meta)) return;
+
+			auto const message = buffer().str();
+			output(*c, log_record{meta, message,
+				body_exception_, log_exception_});
+		}catch(std::exception const& e){
+			std::cerr << "terminate with exception in stdlogd.exec(): "
+				<< e.what() << std::endl;
+			std::terminate();
+		}catch(...){
+			std::cerr << "terminate with unknown exception in stdlogd.exec()"
+				<< std::endl;
+			std::terminate();
+		}
+
+		/// \brief Output a complete record like exec()
+		void exec_record(log_record const& record)noexcept override try{
+			auto const c = config();
+			if(c->accept(record.info)) output(*c, record);
+		}catch(std::exception const& e){
+			std::cerr << "terminate with exception in stdlogd.exec_record(): "
+				<< e.what() << std::endl;
+			std::terminate();
+		}catch(...){
+			std::cerr << "terminate with unknown exception in "
+				"stdlogd.exec_record()" << std::endl;
+			std::terminate();
+		}
+
+
+		/// \brief Append formatted text to the message stream
+		void append(std::string_view text)override{
+			buffer().append(text);
 		}
 
 
@@ -48,6 +95,20 @@ namespace logsys{
 		std::ostream& os()noexcept override{
 			return os_;
 		}
+
+
+	private:
+		/// \brief Retain, coalesce and dispatch an accepted record
+		static void output(configuration const& c, log_record const& record){
+			if(detail::retain(record.info, record.message,
+				record.body_exception, record.log_exception)) return;
+			if(c.coalesce && detail::coalesce(record.info, record.message,
+				record.body_exception, record.log_exception)) return;
+			c.sinks.dispatch(record.info, [&record]{
+					return stdlog::make_log_line(record.info, record.message,
+						record.body_exception, record.log_exception);
+				});
+		}
 	};
 
 
@@ -0,0 +1,31 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__stdlogl__hpp_INCLUDED_
+#define _logsys__stdlogl__hpp_INCLUDED_
+
+#include "stdlog.hpp"
+
+
+namespace logsys{
+
+
+	/// \brief A timed log type with lazy stream creation
+	///
+	/// Output is the same as by stdlog. Construction only takes the ID and
+	/// the time, the std::ostringstream is created by the first insertion
+	/// of a type other than strings, characters, bools and numbers. (See
+	/// lazy_stream_buffer.)
+	using stdlogl = basic_stdlog< lazy_stream_buffer,
+		std::chrono::system_clock, global_id, clog_sink >;
+
+
+}
+
+
+#endif
@@ -0,0 +1,49 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#ifndef _logsys__stdlogt__hpp_INCLUDED_
+#define _logsys__stdlogt__hpp_INCLUDED_
+
+#include "stdlog.hpp"
+
+
+namespace logsys{
+
+
+	/// \brief Compile time binding of an output destination to a Tag type
+	///
+	/// Specialize this template for your own Tag type to redirect the output
+	/// of stdlogt< Tag >:
+	///
+	/// \code
+	/// struct my_tag{};
+	///
+	/// template <> struct logsys::sink_binding< my_tag >{
+	///     static void write(record_info const& info, std::string const& line);
+	/// };
+	/// \endcode
+	///
+	/// The primary template outputs to std::clog.
+	template < typename Tag >
+	struct sink_binding: clog_sink{};
+
+
+	/// \brief Like stdlog, but the output goes to sink_binding< Tag >
+	///
+	/// The destination is selected at compile time, so there is no heap
+	/// allocation and no virtual call like with stdlogb, and the write
+	/// function can be inlined.
+	template < typename Tag >
+	using stdlogt = basic_stdlog< stream_buffer, std::chrono::system_clock,
+		global_id, sink_binding< Tag > >;
+
+
+}
+
+
+#endif
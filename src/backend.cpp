@@ -0,0 +1,1377 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/backend.hpp>
+#include <logsys/stdlog.hpp>
+#include <logsys/detail/page_buffer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+
+namespace logsys{
+
+
+	namespace{
+
+
+		/// \brief Report lost records by a warning line
+		void report_lost(std::size_t count)noexcept try{
+			stdlog log;
+			log << level::warning << "logsys backend lost " << count
+				<< (count == 1 ? " record" : " records")
+				<< " by exhausted byte budget";
+			log.exec();
+		}catch(...){}
+
+
+		/// \brief Let the CPU know that we are spinning
+		inline void cpu_relax()noexcept{
+#if defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+#elif defined(__aarch64__)
+			asm volatile("yield");
+#endif
+		}
+
+
+		/// \brief Sleep and wake on a 32 bit word
+		///
+		/// A futex on Linux, a condition variable elsewhere. wait() returns
+		/// immediately if the word changed since prepare().
+		class wake_signal{
+		public:
+			/// \brief Get the current word before checking for work
+			std::uint32_t prepare()const noexcept{
+				return word_.load();
+			}
+
+			/// \brief Sleep while the word equals seen, at most timeout
+			void wait(std::uint32_t seen, std::chrono::milliseconds timeout)
+			noexcept{
+#ifdef __linux__
+				timespec ts;
+				ts.tv_sec = static_cast< time_t >(timeout.count() / 1000);
+				ts.tv_nsec = static_cast< long >(timeout.count() % 1000)
+					* 1000000;
+				syscall(SYS_futex, futex_word(), FUTEX_WAIT_PRIVATE, seen,
+					&ts, nullptr, 0);
+#else
+				std::unique_lock< std::mutex > lock(mutex_);
+				cv_.wait_for(lock, timeout, [this, seen]{
+						return word_.load() != seen;
+					});
+#endif
+			}
+
+			/// \brief Change the word and wake the sleeper
+			void notify()noexcept{
+				++word_;
+#ifdef __linux__
+				syscall(SYS_futex, futex_word(), FUTEX_WAKE_PRIVATE, 1,
+					nullptr, nullptr, 0);
+#else
+				std::lock_guard< std::mutex > lock(mutex_);
+				cv_.notify_one();
+#endif
+			}
+
+		private:
+#ifdef __linux__
+			static_assert(sizeof(std::atomic< std::uint32_t >) ==
+				sizeof(std::uint32_t));
+			static_assert(std::atomic< std::uint32_t >::is_always_lock_free);
+
+			/// \brief The word as seen by the kernel
+			std::uint32_t* futex_word()noexcept{
+				return reinterpret_cast< std::uint32_t* >(&word_);
+			}
+#else
+			std::mutex mutex_;
+			std::condition_variable cv_;
+#endif
+
+			/// \brief Changed by every notify()
+			std::atomic< std::uint32_t > word_{0};
+		};
+
+
+		/// \brief Executed records between two reclaims while the backend
+		///        is busy
+		constexpr std::size_t reclaim_interval = 256;
+
+
+		/// \brief Time stamp as integer, for atomic storage
+		using time_rep = std::chrono::system_clock::rep;
+
+
+		/// \brief Single producer single consumer ring of records
+		///
+		/// The producer is the owning thread, push() is wait-free. The head
+		/// is only moved under the pop lock, which the backend takes for
+		/// every pop and the producer only for overflow_policy::
+		/// overwrite_oldest. Head and tail count the records since the
+		/// creation of the ring, the queued bytes are counted likewise, so
+		/// the producer needs no read-modify-write on shared counters.
+		class record_ring{
+		public:
+			/// \brief Allocate room for at least capacity records
+			///
+			/// The memory is rounded up to whole pages and fully used.
+			record_ring(
+				std::size_t capacity,
+				huge_pages pages,
+				bool prefault,
+				bool lock
+			):
+				memory_(std::max< std::size_t >(capacity, 1) * sizeof(slot),
+					pages, prefault, lock),
+				capacity_(memory_.size() / sizeof(slot)),
+				slots_(static_cast< slot* >(memory_.data()))
+			{
+				std::uninitialized_default_construct_n(slots_, capacity_);
+			}
+
+			record_ring(record_ring const&) = delete;
+
+			record_ring& operator=(record_ring const&) = delete;
+
+			/// \brief Destroy the remaining records
+			~record_ring(){
+				std::destroy_n(slots_, capacity_);
+			}
+
+
+			/// \brief Producer: append a record, false if the ring is full
+			///
+			/// reserved are the bytes taken from the byte budget.
+			bool push(
+				detail::closure& record,
+				std::size_t bytes,
+				std::size_t reserved,
+				time_rep time
+			)noexcept{
+				auto const tail = tail_.load(std::memory_order_relaxed);
+				if(tail - head_.load(std::memory_order_acquire) == capacity_){
+					return false;
+				}
+
+				auto& s = slots_[tail % capacity_];
+				s.record = std::move(record);
+				s.bytes = bytes;
+				s.reserved = reserved;
+				s.time.store(time, std::memory_order_relaxed);
+				pushed_bytes_.store(
+					pushed_bytes_.load(std::memory_order_relaxed) + bytes,
+					std::memory_order_relaxed);
+				tail_.store(tail + 1, std::memory_order_release);
+				return true;
+			}
+
+			/// \brief Remove the oldest record, false if the ring is empty
+			///
+			/// reserved are the bytes to return to the byte budget.
+			bool pop(detail::closure& record, std::size_t& reserved)noexcept{
+				while(pop_lock_.test_and_set(std::memory_order_acquire)){
+					std::this_thread::yield();
+				}
+
+				auto const head = head_.load(std::memory_order_relaxed);
+				auto const found =
+					head != tail_.load(std::memory_order_acquire);
+				if(found){
+					auto& s = slots_[head % capacity_];
+					record = std::move(s.record);
+					reserved = s.reserved;
+					popped_bytes_.store(
+						popped_bytes_.load(std::memory_order_relaxed) + s.bytes,
+						std::memory_order_release);
+					head_.store(head + 1, std::memory_order_release);
+				}
+
+				pop_lock_.clear(std::memory_order_release);
+				return found;
+			}
+
+			/// \brief Time of the oldest record, false if the ring is empty
+			bool front_time(time_rep& time)const noexcept{
+				auto const head = head_.load(std::memory_order_acquire);
+				if(head == tail_.load(std::memory_order_acquire)) return false;
+				time = slots_[head % capacity_].time.load(
+					std::memory_order_relaxed);
+				return true;
+			}
+
+			/// \brief true if no record is queued
+			bool empty()const noexcept{
+				return head_.load(std::memory_order_acquire) ==
+					tail_.load(std::memory_order_acquire);
+			}
+
+			/// \brief Count of records pushed since creation
+			std::size_t pushed()const noexcept{
+				return tail_.load(std::memory_order_acquire);
+			}
+
+			/// \brief Count a popped record as executed or discarded
+			void finish()noexcept{
+				// the backend and an overwriting producer may both finish
+				finished_.fetch_add(1, std::memory_order_release);
+			}
+
+			/// \brief Count of records executed or discarded since creation
+			///
+			/// Lags behind the popped records while a record executes.
+			std::size_t finished()const noexcept{
+				return finished_.load(std::memory_order_acquire);
+			}
+
+			/// \brief Bytes of the queued records
+			std::size_t queued_bytes()const noexcept{
+				// popped first, so the difference can not underflow
+				auto const popped =
+					popped_bytes_.load(std::memory_order_acquire);
+				return pushed_bytes_.load(std::memory_order_acquire) - popped;
+			}
+
+
+			/// \brief Set when the producer thread ended
+			std::atomic< bool > orphaned{false};
+
+			/// \brief true while the producer is in backend::post()
+			alignas(64) std::atomic< bool > posting{false};
+
+			/// \brief NUMA node of the producer when it created the ring
+			std::size_t node = 0;
+
+			/// \brief Bytes of the ring memory
+			std::size_t memory_size()const noexcept{
+				return memory_.size();
+			}
+
+
+		private:
+			/// \brief A queued record
+			struct slot{
+				detail::closure record;
+				std::size_t bytes = 0;
+				std::size_t reserved = 0;
+				std::atomic< time_rep > time{0};
+			};
+
+			/// \brief Memory of the records
+			detail::page_buffer memory_;
+
+			/// \brief Maximal count of records
+			std::size_t const capacity_;
+
+			/// \brief The records
+			slot* const slots_;
+
+			/// \brief Index of the oldest record
+			alignas(64) std::atomic< std::size_t > head_{0};
+
+			/// \brief Bytes of all popped records
+			std::atomic< std::size_t > popped_bytes_{0};
+
+			/// \brief Count of finished records, see finish()
+			std::atomic< std::size_t > finished_{0};
+
+			/// \brief Index behind the newest record
+			alignas(64) std::atomic< std::size_t > tail_{0};
+
+			/// \brief Bytes of all pushed records
+			std::atomic< std::size_t > pushed_bytes_{0};
+
+			/// \brief Serializes all movements of head_
+			std::atomic_flag pop_lock_ = ATOMIC_FLAG_INIT;
+		};
+
+
+		/// \brief Owner of the calling thread's ring
+		struct ring_handle{
+			/// \brief Mark the ring for reclamation by the backend
+			~ring_handle(){
+				if(ring) ring->orphaned = true;
+			}
+
+			std::shared_ptr< record_ring > ring;
+		};
+
+		/// \brief The ring of the calling thread
+		thread_local ring_handle local_handle;
+
+		/// \brief true while the calling thread executes records
+		///
+		/// For the whole life of a backend thread, in poll mode during
+		/// drain().
+		thread_local bool executing_records = false;
+
+
+		/// \brief A backend thread and its wakeup state
+		struct shard{
+			/// \brief Signaled on new records, lost records and stop
+			wake_signal ready;
+
+			/// \brief true while the thread sleeps
+			std::atomic< bool > parked{false};
+
+			/// \brief The thread
+			std::thread thread;
+		};
+
+
+		/// \brief Marks the producer of ring as active in post()
+		struct post_guard{
+			explicit post_guard(record_ring& ring)noexcept:
+				ring(ring)
+			{
+				ring.posting = true;
+			}
+
+			~post_guard(){
+				ring.posting.store(false, std::memory_order_release);
+			}
+
+			record_ring& ring;
+		};
+
+		/// \brief Counts the calling thread while in scope
+		struct count_guard{
+			explicit count_guard(std::atomic< std::size_t >& count)noexcept:
+				count(count)
+			{
+				++count;
+			}
+
+			~count_guard(){
+				--count;
+			}
+
+			std::atomic< std::size_t >& count;
+		};
+
+
+		class backend;
+
+		/// \brief The backend for the fork handlers, nullptr if not alive
+		std::atomic< backend* > backend_instance(nullptr);
+
+
+		/// \brief Per thread rings and the threads that execute their records
+		///
+		/// Every producer thread owns a record_ring that is registered on its
+		/// first post and reclaimed after the thread ended and the ring is
+		/// empty. A backend thread merges its rings by the record time
+		/// stamps. With NUMA shards every node has its own backend thread,
+		/// rings are assigned by the node of the producer.
+		class backend{
+		public:
+			/// \brief Register the fork handlers
+			backend()noexcept{
+				backend_instance = this;
+#ifdef __linux__
+				static bool const registered = []{
+						pthread_atfork(
+							[]{ with_instance(&backend::prepare_fork); },
+							[]{ with_instance(&backend::parent_after_fork); },
+							[]{ with_instance(&backend::child_after_fork); });
+						return true;
+					}();
+				(void)registered;
+#endif
+			}
+
+			/// \brief Stop on program exit
+			~backend(){
+				backend_instance = nullptr;
+				stop();
+#ifdef __linux__
+				if(event_fd_ >= 0) ::close(event_fd_);
+#endif
+			}
+
+
+			void start(backend_options const& options){
+				std::lock_guard< std::mutex > start_lock(start_mutex_);
+				start_locked(options);
+			}
+
+			void start_polling(
+				backend_options const& options,
+				std::size_t threshold
+			){
+				std::lock_guard< std::mutex > start_lock(start_mutex_);
+				start_polling_locked(options, threshold);
+			}
+
+			void stop()noexcept{
+				std::lock_guard< std::mutex > start_lock(start_mutex_);
+				stop_thread();
+				stop_polling();
+			}
+
+			std::size_t flush_some(std::size_t budget)noexcept{
+				if(!polling_) return 0;
+				return drain(budget, false);
+			}
+
+			int event_fd()const noexcept{
+				return event_fd_;
+			}
+
+			bool running()noexcept{
+				return running_;
+			}
+
+			void flush()noexcept{
+				if(polling_){
+					drain(std::numeric_limits< std::size_t >::max(), true);
+					return;
+				}
+
+				// records posted so far per ring
+				std::vector< std::pair<
+					std::shared_ptr< record_ring >, std::size_t > > targets;
+				try{
+					std::lock_guard< std::mutex > lock(rings_mutex_);
+					targets.reserve(rings_.size());
+					for(auto const& ring: rings_){
+						targets.emplace_back(ring, ring->pushed());
+					}
+				}catch(...){
+					// no memory for the targets, nothing to wait for
+					return;
+				}
+
+				++flushing_;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				{
+					std::unique_lock< std::mutex > lock(mutex_);
+					done_.wait(lock, [this, &targets]{
+							return !running_ || std::all_of(
+								targets.begin(), targets.end(),
+								[](auto const& target){
+									return target.first->finished() >=
+										target.second;
+								});
+						});
+				}
+				--flushing_;
+			}
+
+			backend_counters statistics()noexcept{
+				backend_counters result;
+				{
+					std::lock_guard< std::mutex > lock(rings_mutex_);
+					result.posted = retired_records_;
+					for(auto const& ring: rings_){
+						result.posted += ring->pushed();
+						result.queued_bytes += ring->queued_bytes();
+					}
+				}
+
+				// without byte budget the peak is sampled here
+				auto peak = peak_bytes_.load();
+				while(result.queued_bytes > peak &&
+					!peak_bytes_.compare_exchange_weak(
+						peak, result.queued_bytes));
+
+				result.executed = executed_;
+				result.blocked = blocked_;
+				result.block_timeouts = block_timeouts_;
+				result.dropped_newest = dropped_newest_;
+				result.overwritten = overwritten_;
+				result.synchronous = synchronous_;
+				result.peak_bytes = std::max(peak, result.queued_bytes);
+				result.parks = parks_;
+				result.wakeups = wakeups_;
+				result.ring_bytes = ring_bytes_;
+				return result;
+			}
+
+			bool post(
+				detail::closure& record,
+				std::chrono::system_clock::time_point time
+			){
+				if(!running_) return false;
+
+				auto& ring = local_ring();
+				post_guard guard(ring);
+				if(!running_) return false;
+
+				auto const size = record.footprint();
+				auto const rep = time.time_since_epoch().count();
+
+				if(!try_push(ring, record, size, rep)){
+					switch(policy_.load()){
+						case overflow_policy::block:
+							++blocked_;
+							if(!wait_for_space(ring, record, size, rep)){
+								if(!running_) return false;
+								++block_timeouts_;
+								++lost_;
+								return true;
+							}
+						break;
+						case overflow_policy::drop_newest:
+							++dropped_newest_;
+							++lost_;
+						return true;
+						case overflow_policy::overwrite_oldest:
+							do{
+								detail::closure oldest;
+								std::size_t reserved;
+								if(!ring.pop(oldest, reserved)){
+									++dropped_newest_;
+									++lost_;
+									return true;
+								}
+								release(reserved);
+								ring.finish();
+								++overwritten_;
+								if(polling_) --queued_records_;
+								++lost_;
+							}while(!try_push(ring, record, size, rep));
+						break;
+						case overflow_policy::synchronous:
+							++synchronous_;
+						return false;
+					}
+				}
+
+				if(polling_){
+					++queued_records_;
+					signal_event();
+					return true;
+				}
+
+				// only the first producer wakes the sleeping backend thread
+				auto& s = *shards_[ring.node % shards_.size()];
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if(s.parked.load() && s.parked.exchange(false)) wake(s);
+				return true;
+			}
+
+
+		private:
+			/// \brief Start the backend threads, start_mutex_ is locked
+			void start_locked(backend_options const& options){
+				set_options(options);
+
+				if(!shards_.empty()) return;
+				stop_polling();
+				stop_ = false;
+
+				std::vector< std::vector< int > > nodes;
+				std::vector< std::vector< int > > cpus;
+				if(options.numa_shards){
+					nodes = detail::numa_nodes(options.simulated_numa_nodes);
+					cpus = nodes;
+				}else{
+					cpus.push_back(options.cpu_affinity);
+				}
+
+				{
+					// read by producers in local_ring()
+					std::lock_guard< std::mutex > lock(rings_mutex_);
+					nodes_ = std::move(nodes);
+				}
+
+				for(std::size_t i = 0; i < cpus.size(); ++i){
+					auto& s = *shards_.emplace_back(std::make_unique< shard >());
+					s.thread = std::thread([this, &s, i, count = cpus.size()]{
+							run(s, i, count);
+						});
+					if(options.numa_shards && cpus[i].empty()){
+						std::cerr << "logsys backend shard " << i
+							<< " has no CPUs and is not pinned" << std::endl;
+					}else if(!detail::pin_thread(s.thread, cpus[i])){
+						std::cerr << "logsys backend shard " << i
+							<< " not pinned" << std::endl;
+					}
+				}
+
+				// producers use shards_ from now on
+				running_ = true;
+			}
+
+			/// \brief Enter the poll mode, start_mutex_ is locked
+			void start_polling_locked(
+				backend_options const& options,
+				std::size_t threshold
+			){
+				set_options(options);
+				poll_threshold_ = std::max< std::size_t >(threshold, 1);
+
+#ifdef __linux__
+				if(event_fd_ < 0){
+					event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+					if(event_fd_ < 0){
+						throw std::system_error(errno, std::system_category(),
+							"logsys backend eventfd");
+					}
+				}
+#endif
+
+				if(polling_) return;
+				stop_thread();
+				polling_ = true;
+				running_ = true;
+			}
+
+
+			/// \brief Call f on the living backend
+			static void with_instance(void(backend::*f)()noexcept)noexcept{
+				if(auto const instance = backend_instance.load()){
+					(instance->*f)();
+				}
+			}
+
+			/// \brief Before fork(): execute all records and hold all locks
+			///
+			/// The child must neither inherit queued records, which the
+			/// parent outputs too, nor a mutex locked by a thread that does
+			/// not exist in the child.
+			///
+			/// A log function or sink that calls fork() runs on a thread
+			/// that executes records, which can not wait for itself. Then
+			/// nothing is done and the child must only call
+			/// async-signal-safe functions until exec().
+			///
+			/// Only the backend mutexes are held. The mutexes of sinks
+			/// (e.g. ostream_sink), of the config writer and of the
+			/// coalescer are not, the child must not log before exec() if
+			/// another thread might have held them.
+			void prepare_fork()noexcept{
+				if(executing_records) return;
+
+				start_mutex_.lock();
+				if(!shards_.empty()){
+					fork_mode_ = mode::thread;
+				}else if(polling_){
+					fork_mode_ = mode::poll;
+				}else{
+					fork_mode_ = mode::off;
+				}
+
+				stop_thread();
+				stop_polling();
+
+				poll_mutex_.lock();
+				mutex_.lock();
+				rings_mutex_.lock();
+			}
+
+			/// \brief After fork() in the parent: continue as before
+			void parent_after_fork()noexcept{
+				if(executing_records) return;
+
+				rings_mutex_.unlock();
+				mutex_.unlock();
+				poll_mutex_.unlock();
+				restart();
+				start_mutex_.unlock();
+			}
+
+			/// \brief After fork() in the child: forget the other threads
+			///
+			/// Only the forking thread exists in the child. The rings of
+			/// the other threads are empty and never used again, their
+			/// memory is not released. The child gets its own event fd and
+			/// new per_thread_id numbers.
+			void child_after_fork()noexcept{
+				if(executing_records){
+					++detail::fork_generation();
+					return;
+				}
+
+				rings_mutex_.unlock();
+				mutex_.unlock();
+				poll_mutex_.unlock();
+
+				auto const end = std::remove_if(rings_.begin(), rings_.end(),
+					[](auto const& ring){ return ring != local_handle.ring; });
+				for(auto i = end; i != rings_.end(); ++i){
+					ring_bytes_ -= (*i)->memory_size();
+					retired_records_ += (*i)->pushed();
+				}
+				rings_.erase(end, rings_.end());
+				++rings_version_;
+				poll_rings_ = ring_snapshot();
+
+				if(local_handle.ring) local_handle.ring->posting = false;
+				waiting_producers_ = 0;
+				flushing_ = 0;
+
+#ifdef __linux__
+				if(event_fd_ >= 0){
+					::close(event_fd_);
+					event_fd_ = -1;
+				}
+				event_signaled_ = false;
+#endif
+
+				++detail::fork_generation();
+
+				restart();
+				start_mutex_.unlock();
+			}
+
+			/// \brief Restart in the mode before fork()
+			void restart()noexcept try{
+				switch(fork_mode_){
+					case mode::thread:
+						start_locked(options_);
+					break;
+					case mode::poll:
+						start_polling_locked(options_, poll_threshold_);
+					break;
+					case mode::off:
+					break;
+				}
+			}catch(std::exception const& e){
+				std::cerr << "logsys backend not restarted after fork: "
+					<< e.what() << std::endl;
+			}catch(...){
+				std::cerr << "logsys backend not restarted after fork"
+					<< std::endl;
+			}
+
+
+			/// \brief Apply options
+			void set_options(backend_options const& options){
+				options_ = options;
+				byte_budget_ = options.byte_budget;
+				policy_ = options.policy;
+				block_timeout_ = options.block_timeout;
+				reorder_window_ = options.reorder_window;
+				spin_limit_ = options.spin_limit;
+				yield_limit_ = options.yield_limit;
+				ring_capacity_ = options.ring_capacity;
+				ring_pages_ = options.ring_pages;
+				prefault_ = options.prefault;
+				lock_memory_ = options.lock_memory;
+			}
+
+			/// \brief Execute all records and end the backend threads
+			void stop_thread()noexcept{
+				if(shards_.empty()) return;
+
+				stop_ = true;
+				for(auto& s: shards_) wake(*s);
+				for(auto& s: shards_) s->thread.join();
+				shards_.clear();
+			}
+
+			/// \brief Execute all records and end the poll mode
+			void stop_polling()noexcept{
+				if(!polling_) return;
+
+				close();
+				drain(std::numeric_limits< std::size_t >::max(), true);
+				polling_ = false;
+			}
+
+		public:
+			/// \brief The ring of the calling thread, created on first use
+			record_ring& local_ring(){
+				auto& handle = local_handle;
+				if(!handle.ring){
+					auto ring = std::make_shared< record_ring >(ring_capacity_,
+						ring_pages_, prefault_, lock_memory_);
+					ring_bytes_ += ring->memory_size();
+					std::lock_guard< std::mutex > lock(rings_mutex_);
+					ring->node = detail::current_node(nodes_);
+					rings_.push_back(ring);
+					++rings_version_;
+					handle.ring = std::move(ring);
+				}
+				return *handle.ring;
+			}
+
+		private:
+
+			/// \brief Take size bytes from the budget
+			///
+			/// Without budget nothing is reserved, so the producers share no
+			/// counter. (The queued bytes are summed from the rings.)
+			///
+			/// \return the reserved bytes
+			bool reserve(std::size_t size, std::size_t& reserved)noexcept{
+				auto const budget = byte_budget_.load();
+				if(budget == 0){
+					reserved = 0;
+					return true;
+				}
+
+				auto queued = budget_bytes_.load();
+				do{
+					if(queued != 0 && queued + size > budget) return false;
+				}while(!budget_bytes_.compare_exchange_weak(
+					queued, queued + size));
+
+				auto peak = peak_bytes_.load();
+				while(queued + size > peak &&
+					!peak_bytes_.compare_exchange_weak(peak, queued + size));
+				reserved = size;
+				return true;
+			}
+
+			/// \brief Give reserved bytes back to the budget
+			void release(std::size_t reserved)noexcept{
+				if(reserved != 0) budget_bytes_ -= reserved;
+			}
+
+			/// \brief Push record if it fits into budget and ring
+			bool try_push(
+				record_ring& ring,
+				detail::closure& record,
+				std::size_t size,
+				time_rep time
+			)noexcept{
+				std::size_t reserved;
+				if(!reserve(size, reserved)) return false;
+				if(ring.push(record, size, reserved, time)) return true;
+				release(reserved);
+				return false;
+			}
+
+			/// \brief Push record as soon as it fits
+			///
+			/// \return false on timeout or if the backend stopped
+			bool wait_for_space(
+				record_ring& ring,
+				detail::closure& record,
+				std::size_t size,
+				time_rep time
+			){
+				count_guard waiting(waiting_producers_);
+				auto const until =
+					std::chrono::steady_clock::now() + block_timeout_.load();
+
+				std::unique_lock< std::mutex > lock(mutex_);
+				for(;;){
+					if(try_push(ring, record, size, time)) return true;
+					if(!running_) return false;
+
+					auto const now = std::chrono::steady_clock::now();
+					if(now >= until) return false;
+					space_.wait_for(lock, std::min< std::chrono::nanoseconds >(
+						until - now, std::chrono::milliseconds(100)));
+				}
+			}
+
+			/// \brief Wake a backend thread
+			void wake(shard& s)noexcept{
+				++wakeups_;
+				s.ready.notify();
+			}
+
+			/// \brief true if the backend thread has something to do
+			bool has_work(
+				std::vector< std::shared_ptr< record_ring > > const& rings,
+				std::size_t version
+			)const noexcept{
+				return stop_ || lost_ > 0 || rings_version_ != version ||
+					std::any_of(rings.begin(), rings.end(),
+						[](auto const& ring){ return !ring->empty(); });
+			}
+
+			/// \brief The rings as seen by the consumer
+			struct ring_snapshot{
+				std::vector< std::shared_ptr< record_ring > > rings;
+				std::size_t version = 0;
+			};
+
+			/// \brief Update the snapshot if rings were added or removed
+			///
+			/// Contains the rings of shard index of count shards.
+			void refresh(
+				ring_snapshot& snapshot,
+				std::size_t index = 0,
+				std::size_t count = 1
+			){
+				if(snapshot.version == rings_version_) return;
+				std::lock_guard< std::mutex > lock(rings_mutex_);
+				snapshot.rings.clear();
+				for(auto const& ring: rings_){
+					if(ring->node % count == index){
+						snapshot.rings.push_back(ring);
+					}
+				}
+				snapshot.version = rings_version_;
+			}
+
+			/// \brief The ring with the oldest record, nullptr if all empty
+			static record_ring* oldest(
+				ring_snapshot const& snapshot,
+				time_rep& oldest_time
+			)noexcept{
+				record_ring* result = nullptr;
+				for(auto const& ring: snapshot.rings){
+					time_rep time;
+					if(ring->front_time(time) &&
+						(result == nullptr || time < oldest_time)
+					){
+						result = ring.get();
+						oldest_time = time;
+					}
+				}
+				return result;
+			}
+
+			/// \brief Remove the empty rings of ended threads
+			///
+			/// Rings that still hold records are kept until they are empty,
+			/// independent of the other rings.
+			///
+			/// \return true if rings were removed
+			bool reclaim(ring_snapshot const& snapshot){
+				auto const reclaimable = [](auto const& ring){
+						return ring->orphaned && ring->empty();
+					};
+				if(std::none_of(snapshot.rings.begin(), snapshot.rings.end(),
+					reclaimable)) return false;
+
+				std::lock_guard< std::mutex > lock(rings_mutex_);
+				auto const end = std::remove_if(rings_.begin(), rings_.end(),
+					reclaimable);
+				if(end == rings_.end()) return false;
+				for(auto i = end; i != rings_.end(); ++i){
+					ring_bytes_ -= (*i)->memory_size();
+					retired_records_ += (*i)->pushed();
+				}
+				rings_.erase(end, rings_.end());
+				++rings_version_;
+				return true;
+			}
+
+			/// \brief Execute the oldest record of ring
+			void execute_from(record_ring& ring)noexcept{
+				detail::closure record;
+				std::size_t reserved;
+				if(!ring.pop(record, reserved)) return;
+
+				release(reserved);
+				if(waiting_producers_ > 0){
+					std::lock_guard< std::mutex > lock(mutex_);
+					space_.notify_all();
+				}
+
+				execute(record);
+				ring.finish();
+
+				++executed_;
+				if(polling_) --queued_records_;
+
+				// pairs with the fence in flush(), either the flushing
+				// thread sees the record finished or it is notified
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if(flushing_ > 0){
+					std::lock_guard< std::mutex > lock(mutex_);
+					done_.notify_all();
+				}
+			}
+
+			/// \brief Report lost records if there are any
+			void report_lost_records()noexcept{
+				if(auto const lost = lost_.exchange(0); lost > 0){
+					report_lost(lost);
+				}
+			}
+
+			/// \brief Thread function, runs until stop and empty rings
+			void run(shard& s, std::size_t index, std::size_t count)noexcept{
+				executing_records = true;
+
+				ring_snapshot snapshot;
+				std::size_t executed = 0;
+
+				for(;;){
+					refresh(snapshot, index, count);
+					report_lost_records();
+
+					time_rep time = 0;
+					if(auto const next = oldest(snapshot, time)){
+						if(!stop_ && wait_for_window(time)) continue;
+						execute_from(*next);
+						if(++executed % reclaim_interval == 0){
+							reclaim(snapshot);
+						}
+						continue;
+					}
+
+					if(reclaim(snapshot)) continue;
+
+					if(stop_){
+						if(running_){
+							// no new records after all posts are finished
+							close();
+							continue;
+						}
+
+						std::lock_guard< std::mutex > lock(mutex_);
+						done_.notify_all();
+						return;
+					}
+
+					park(s, snapshot.rings, snapshot.version);
+				}
+			}
+
+			/// \brief Accept no more records, wait for running posts
+			void close()noexcept{
+				{
+					std::lock_guard< std::mutex > lock(mutex_);
+					running_ = false;
+				}
+				space_.notify_all();
+
+				std::lock_guard< std::mutex > lock(rings_mutex_);
+				for(auto const& ring: rings_){
+					while(ring->posting) std::this_thread::yield();
+				}
+			}
+
+			/// \brief Execute up to budget records by the calling thread
+			std::size_t drain(std::size_t budget, bool ignore_window)noexcept{
+				std::lock_guard< std::mutex > lock(poll_mutex_);
+				auto const was_executing =
+					std::exchange(executing_records, true);
+
+				std::size_t count = 0;
+				while(count < budget){
+					refresh(poll_rings_);
+					report_lost_records();
+
+					time_rep time = 0;
+					auto const next = oldest(poll_rings_, time);
+					if(next == nullptr){
+						if(reclaim(poll_rings_)) continue;
+						break;
+					}
+
+					if(!ignore_window && too_young(time)) break;
+					execute_from(*next);
+					if(++count % reclaim_interval == 0){
+						reclaim(poll_rings_);
+					}
+				}
+
+				reset_event();
+				executing_records = was_executing;
+				return count;
+			}
+
+			/// \brief true if the record at time is within the reorder window
+			bool too_young(time_rep time)const noexcept{
+				auto const window = reorder_window_.load();
+				if(window.count() <= 0) return false;
+
+				auto const record_time = std::chrono::system_clock::time_point(
+					std::chrono::system_clock::duration(time));
+				return record_time + window > std::chrono::system_clock::now();
+			}
+
+			/// \brief true if at least poll_threshold_ records are queued
+			bool threshold_reached()const noexcept{
+				auto const queued = queued_records_.load();
+				return queued > 0 &&
+					static_cast< std::size_t >(queued) >= poll_threshold_;
+			}
+
+			/// \brief Make the event fd readable if the threshold is reached
+			void signal_event()noexcept{
+				if(!threshold_reached()) return;
+				if(event_signaled_.exchange(true)) return;
+#ifdef __linux__
+				std::uint64_t const one = 1;
+				[[maybe_unused]] auto const r =
+					::write(event_fd_, &one, sizeof(one));
+#endif
+			}
+
+			/// \brief Make the event fd unreadable if below the threshold
+			///
+			/// Called under poll_mutex_. The fd is read before the flag is
+			/// cleared, so a producer can not write in between and lose its
+			/// wakeup by the read. One that reached the threshold while the
+			/// flag was still set is caught by the second check.
+			void reset_event()noexcept{
+				if(threshold_reached()) return;
+				if(!event_signaled_.load()) return;
+#ifdef __linux__
+				std::uint64_t value;
+				[[maybe_unused]] auto const r =
+					::read(event_fd_, &value, sizeof(value));
+#endif
+				event_signaled_ = false;
+				signal_event();
+			}
+
+			/// \brief Sleep until the record at time is older than the
+			///        reorder window
+			///
+			/// \return true if it was too young
+			bool wait_for_window(time_rep time)noexcept{
+				auto const window = reorder_window_.load();
+				if(window.count() <= 0) return false;
+
+				auto const record_time = std::chrono::system_clock::time_point(
+					std::chrono::system_clock::duration(time));
+				auto const ready = record_time + window;
+				auto const now = std::chrono::system_clock::now();
+				if(ready <= now) return false;
+
+				std::this_thread::sleep_for(ready - now);
+				return true;
+			}
+
+			/// \brief Wait until a producer posts a record or stop
+			///
+			/// Spins spin_limit times, then yields yield_limit times, then
+			/// sleeps. Only the sleep needs a wakeup by the producers.
+			void park(
+				shard& s,
+				std::vector< std::shared_ptr< record_ring > > const& rings,
+				std::size_t version
+			)noexcept{
+				auto const spins = spin_limit_.load();
+				for(std::size_t i = 0; i < spins; ++i){
+					if(has_work(rings, version)) return;
+					cpu_relax();
+				}
+
+				auto const yields = yield_limit_.load();
+				for(std::size_t i = 0; i < yields; ++i){
+					if(has_work(rings, version)) return;
+					std::this_thread::yield();
+				}
+
+				auto const seen = s.ready.prepare();
+				s.parked = true;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if(!has_work(rings, version)){
+					++parks_;
+					s.ready.wait(seen, std::chrono::milliseconds(1000));
+				}
+				s.parked = false;
+			}
+
+			/// \brief Execute a record, the Log types exec() is noexcept
+			static void execute(detail::closure& record)noexcept try{
+				record();
+			}catch(std::exception const& e){
+				std::cerr << "deferred log record lost by exception: "
+					<< e.what() << std::endl;
+			}catch(...){
+				std::cerr << "deferred log record lost by unknown exception"
+					<< std::endl;
+			}
+
+
+			/// \brief Serializes start() and stop()
+			std::mutex start_mutex_;
+
+			/// \brief Options of the last start
+			backend_options options_;
+
+			/// \brief Operating modes
+			enum class mode{ off, thread, poll };
+
+			/// \brief Mode before fork()
+			mode fork_mode_ = mode::off;
+
+			/// \brief Protects the sleeps on the condition variables
+			std::mutex mutex_;
+
+			/// \brief Signaled on executed records and thread end
+			std::condition_variable done_;
+
+			/// \brief Signaled when queued bytes are freed
+			std::condition_variable space_;
+
+			/// \brief Protects rings_, retired_records_ and nodes_
+			///
+			/// Locked after mutex_ if both are needed.
+			std::mutex rings_mutex_;
+
+			/// \brief The rings of all producer threads
+			std::vector< std::shared_ptr< record_ring > > rings_;
+
+			/// \brief Records of the removed rings
+			std::size_t retired_records_ = 0;
+
+			/// \brief Incremented with every change of rings_
+			std::atomic< std::size_t > rings_version_{0};
+
+			/// \brief Options, see backend_options
+			std::atomic< std::size_t > byte_budget_{0};
+			std::atomic< overflow_policy > policy_{overflow_policy::block};
+			std::atomic< std::chrono::milliseconds > block_timeout_{
+				std::chrono::milliseconds(100)};
+			std::atomic< std::chrono::microseconds > reorder_window_{
+				std::chrono::microseconds(0)};
+			std::atomic< std::size_t > spin_limit_{0};
+			std::atomic< std::size_t > yield_limit_{0};
+			std::atomic< std::size_t > ring_capacity_{512};
+			std::atomic< huge_pages > ring_pages_{huge_pages::none};
+			std::atomic< bool > prefault_{false};
+			std::atomic< bool > lock_memory_{false};
+
+			/// \brief Counters, see backend_counters
+			///
+			/// posted and queued_bytes are summed from the rings.
+			std::atomic< std::size_t > executed_{0};
+			std::atomic< std::size_t > blocked_{0};
+			std::atomic< std::size_t > block_timeouts_{0};
+			std::atomic< std::size_t > dropped_newest_{0};
+			std::atomic< std::size_t > overwritten_{0};
+			std::atomic< std::size_t > synchronous_{0};
+			std::atomic< std::size_t > peak_bytes_{0};
+			std::atomic< std::size_t > parks_{0};
+			std::atomic< std::size_t > wakeups_{0};
+			std::atomic< std::size_t > ring_bytes_{0};
+
+			/// \brief Bytes reserved from the byte budget
+			std::atomic< std::size_t > budget_bytes_{0};
+
+			/// \brief Number of records queued in poll mode
+			///
+			/// Decremented when a record is executed or overwritten. Signed,
+			/// because a record can be popped before its producer counted
+			/// it, then it is -1 for a moment instead of wrapping around.
+			std::atomic< std::ptrdiff_t > queued_records_{0};
+
+			/// \brief Number of lost records not reported yet
+			std::atomic< std::size_t > lost_{0};
+
+			/// \brief Count of producers in wait_for_space()
+			std::atomic< std::size_t > waiting_producers_{0};
+
+			/// \brief Count of threads in flush()
+			std::atomic< std::size_t > flushing_{0};
+
+			/// \brief true while records are accepted
+			std::atomic< bool > running_{false};
+
+			/// \brief Thread shall end when the rings are empty
+			std::atomic< bool > stop_{false};
+
+			/// \brief Serializes the consumers in poll mode
+			std::mutex poll_mutex_;
+
+			/// \brief The rings as seen in poll mode
+			ring_snapshot poll_rings_;
+
+			/// \brief Queued records that make event_fd_ readable
+			std::atomic< std::size_t > poll_threshold_{1};
+
+			/// \brief Readable if the threshold is reached, -1 if none
+			int event_fd_ = -1;
+
+			/// \brief true while event_fd_ is readable
+			std::atomic< bool > event_signaled_{false};
+
+			/// \brief true in poll mode
+			std::atomic< bool > polling_{false};
+
+			/// \brief CPUs of the NUMA nodes, empty without NUMA shards
+			///
+			/// Written by start_locked() and read by local_ring() under
+			/// rings_mutex_.
+			std::vector< std::vector< int > > nodes_;
+
+			/// \brief The backend threads
+			std::vector< std::unique_ptr< shard > > shards_;
+		};
+
+		backend& the_backend()noexcept{
+			static backend instance;
+			return instance;
+		}
+
+
+	}
+
+
+	void start_backend(backend_options const& options){
+		the_backend().start(options);
+	}
+
+	void stop_backend()noexcept{
+		the_backend().stop();
+	}
+
+	bool backend_running()noexcept{
+		return the_backend().running();
+	}
+
+	void flush_backend()noexcept{
+		the_backend().flush();
+	}
+
+	backend_counters backend_statistics()noexcept{
+		return the_backend().statistics();
+	}
+
+	void start_polling(backend_options const& options, std::size_t threshold){
+		the_backend().start_polling(options, threshold);
+	}
+
+	std::size_t flush_some(std::size_t budget)noexcept{
+		return the_backend().flush_some(budget);
+	}
+
+	int backend_event_fd()noexcept{
+		return the_backend().event_fd();
+	}
+
+	void prepare_backend_thread(){
+		the_backend().local_ring();
+	}
+
+
+	namespace detail{
+
+
+		bool backend_post(
+			closure& record,
+			std::chrono::system_clock::time_point time
+		){
+			return the_backend().post(record, time);
+		}
+
+
+	}
+
+
+}
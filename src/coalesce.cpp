@@ -0,0 +1,234 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/coalesce.hpp>
+#include <logsys/config.hpp>
+#include <logsys/stdlog.hpp>
+
+#include <io_tools/time_to_string.hpp>
+
+#include <boost/type_index.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+
+namespace logsys{
+
+
+	namespace{
+
+
+		/// \brief Type and what() of an exception, empty if none
+		std::string describe(std::exception_ptr const& exception){
+			if(!exception) return {};
+
+			try{
+				std::rethrow_exception(exception);
+			}catch(std::exception const& error){
+				using boost::typeindex::type_id_runtime;
+				return type_id_runtime(error).pretty_name() + ": "
+					+ error.what();
+			}catch(...){
+				return "unknown exception";
+			}
+		}
+
+		/// \brief Output a duration in milliseconds as stdlog does
+		void write_ms(
+			std::ostream& os,
+			std::chrono::system_clock::duration duration
+		){
+			auto const ms =
+				std::chrono::duration< double, std::milli >(duration).count();
+			detail::number_chars< double > text(ms, 3);
+			if(text.valid()){
+				os << text.view();
+			}else{
+				os << std::setprecision(3) << ms;
+			}
+		}
+
+		/// \brief Hash of all compared parts of a record
+		std::size_t hash_of(
+			record_info const& info,
+			std::string_view message,
+			std::string_view body_exception,
+			std::string_view log_exception
+		)noexcept{
+			std::hash< std::string_view > const hash_text;
+			auto hash = hash_text(message);
+			hash ^= (static_cast< std::size_t >(info.body) << 1)
+				^ (static_cast< std::size_t >(info.log_exception) << 4)
+				^ (static_cast< std::size_t >(info.level) << 5)
+				^ (hash_text(body_exception) << 7)
+				^ (hash_text(log_exception) << 11);
+			return hash;
+		}
+
+		/// \brief Output a summary to the sinks
+		void output(repeat_summary const& summary){
+			auto const c = config();
+			if(!c->accept(summary.last)) return;
+			c->sinks.dispatch(summary.last,
+				[&summary]{ return summary.make_log_line(); });
+		}
+
+
+		/// \brief Coalescer of a thread, outputs its summary on thread exit
+		struct thread_coalescer{
+			~thread_coalescer(){
+				auto summary = instance.flush();
+				if(!summary) return;
+
+				try{
+					output(*summary);
+				}catch(...){
+					// thread exit, nowhere to report
+				}
+			}
+
+			coalescer instance;
+		};
+
+		coalescer& this_thread_coalescer()noexcept{
+			thread_local thread_coalescer result;
+			return result.instance;
+		}
+
+
+	}
+
+
+	std::string repeat_summary::make_log_line()const{
+		std::ostringstream os;
+		os << "previous message repeated " << count << " times until ";
+		io_tools::time_to_string(os, last.start);
+
+		if(last.body != body_state::none){
+			os << " (body duration min ";
+			write_ms(os, min_duration);
+			os << "ms, max ";
+			write_ms(os, max_duration);
+			os << "ms)";
+		}
+
+		// a record without body and exceptions, started by the first
+		// duplicate
+		auto info = last;
+		info.start = first_start;
+		info.end = first_start;
+		info.body = body_state::none;
+		info.log_exception = false;
+		return stdlog::make_log_line(info, os.str(), nullptr, nullptr);
+	}
+
+
+	coalescer::result coalescer::add(
+		record_info const& info,
+		std::string_view message,
+		std::exception_ptr const& body_exception,
+		std::exception_ptr const& log_exception
+	){
+		// the same exception object needs no description
+		auto body_exception_text =
+			body_exception == body_exception_ && active_
+				? body_exception_text_ : describe(body_exception);
+		auto log_exception_text =
+			log_exception == log_exception_ && active_
+				? log_exception_text_ : describe(log_exception);
+
+		auto const hash = hash_of(info, message,
+			body_exception_text, log_exception_text);
+		if(
+			active_ &&
+			hash == hash_ &&
+			info.body == info_.body &&
+			info.log_exception == info_.log_exception &&
+			info.level == info_.level &&
+			message == message_ &&
+			body_exception_text == body_exception_text_ &&
+			log_exception_text == log_exception_text_
+		){
+			auto const duration = info.duration();
+			if(summary_.count == 0){
+				summary_.first_start = info.start;
+				summary_.min_duration = duration;
+				summary_.max_duration = duration;
+			}else{
+				summary_.min_duration =
+					std::min(summary_.min_duration, duration);
+				summary_.max_duration =
+					std::max(summary_.max_duration, duration);
+			}
+
+			++summary_.count;
+			summary_.last = info;
+			return {true, std::nullopt};
+		}
+
+		auto summary = flush();
+
+		active_ = true;
+		hash_ = hash;
+		info_ = info;
+		message_.assign(message.data(), message.size());
+		body_exception_ = body_exception;
+		log_exception_ = log_exception;
+		body_exception_text_ = std::move(body_exception_text);
+		log_exception_text_ = std::move(log_exception_text);
+
+		return {false, std::move(summary)};
+	}
+
+	std::optional< repeat_summary > coalescer::flush()noexcept{
+		if(summary_.count == 0) return std::nullopt;
+
+		auto result = summary_;
+		summary_.count = 0;
+		return result;
+	}
+
+
+	void flush_coalesced()noexcept try{
+		auto summary = this_thread_coalescer().flush();
+		if(summary) output(*summary);
+	}catch(std::exception const& e){
+		std::cerr << "terminate with exception in flush_coalesced(): "
+			<< e.what() << std::endl;
+		std::terminate();
+	}catch(...){
+		std::cerr << "terminate with unknown exception in flush_coalesced()"
+			<< std::endl;
+		std::terminate();
+	}
+
+
+	namespace detail{
+
+
+		bool coalesce(
+			record_info const& info,
+			std::string_view message,
+			std::exception_ptr const& body_exception,
+			std::exception_ptr const& log_exception
+		){
+			auto result = this_thread_coalescer().add(info, message,
+				body_exception, log_exception);
+			if(result.summary) output(*result.summary);
+			return result.duplicate;
+		}
+
+
+	}
+
+
+}
@@ -0,0 +1,286 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/config.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace logsys{
+
+
+	namespace{
+
+
+		/// \brief The read state of one thread
+		///
+		/// Slots are never freed, a slot of an ended thread is reused.
+		struct alignas(64) reader_slot{
+			/// \brief Epoch at the begin of the read section, 0 if none
+			std::atomic< std::uint64_t > epoch{0};
+
+			/// \brief true while a thread owns the slot
+			std::atomic< bool > used{true};
+
+			/// \brief Nesting depth of the read sections, owner only
+			std::size_t depth = 0;
+
+			/// \brief Next slot in the list
+			reader_slot* next = nullptr;
+		};
+
+		/// \brief All slots
+		std::atomic< reader_slot* > slots(nullptr);
+
+		/// \brief Incremented by every publication
+		std::atomic< std::uint64_t > global_epoch(1);
+
+		/// \brief true while replaced configurations wait for readers
+		std::atomic< bool > reclaim_pending(false);
+
+
+		/// \brief Take a free slot or add a new one
+		reader_slot* acquire_slot(){
+			for(auto i = slots.load(); i != nullptr; i = i->next){
+				if(!i->used.load(std::memory_order_relaxed) &&
+					!i->used.exchange(true)) return i;
+			}
+
+			auto const slot = new reader_slot;
+			slot->next = slots.load();
+			while(!slots.compare_exchange_weak(slot->next, slot));
+			return slot;
+		}
+
+		/// \brief The slot of the calling thread
+		thread_local reader_slot* local_slot = nullptr;
+
+		/// \brief true after the slot release of the calling thread
+		thread_local bool slot_released = false;
+
+		/// \brief Returns the slot of the calling thread on thread exit
+		struct slot_owner{
+			~slot_owner(){
+				slot_released = true;
+				if(local_slot == nullptr) return;
+				local_slot->used.store(false, std::memory_order_release);
+				local_slot = nullptr;
+			}
+		};
+
+		/// \brief The slot of the calling thread, acquired on first use
+		reader_slot& thread_slot(){
+			if(local_slot == nullptr){
+				// a reader after the thread_local destruction keeps its
+				// slot forever
+				if(!slot_released){
+					thread_local slot_owner owner;
+					(void)owner;
+				}
+				local_slot = acquire_slot();
+			}
+			return *local_slot;
+		}
+
+
+		/// \brief The current configuration, nullptr until the first use
+		///
+		/// Constant initialized and never destroyed, so it is usable in
+		/// static initialization and destruction of other translation
+		/// units.
+		std::atomic< configuration const* > current_config(nullptr);
+
+		/// \brief Install the default configuration if there is none yet
+		configuration const* default_config()noexcept{
+			auto const config = new configuration const{
+					nullptr,
+					sink_list({std::make_shared< ostream_sink >(std::clog)})
+				};
+
+			configuration const* expected = nullptr;
+			if(current_config.compare_exchange_strong(expected, config)){
+				return config;
+			}
+
+			delete config;
+			return expected;
+		}
+
+		/// \brief configuration::factory of current_config
+		std::atomic< stdlogb_factory > current_factory(nullptr);
+
+		/// \brief Serializes writers and the reclamation
+		std::mutex& writer_mutex(){
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		/// \brief true while the calling thread holds writer_mutex()
+		thread_local bool writing = false;
+
+		/// \brief Lock writer_mutex() and mark the calling thread
+		class writer_lock{
+		public:
+			writer_lock():
+				lock_(writer_mutex())
+			{
+				writing = true;
+			}
+
+			explicit writer_lock(std::try_to_lock_t):
+				lock_(writer_mutex(), std::try_to_lock)
+			{
+				writing = lock_.owns_lock();
+			}
+
+			~writer_lock(){
+				writing = false;
+			}
+
+			bool owns_lock()const noexcept{
+				return lock_.owns_lock();
+			}
+
+		private:
+			std::unique_lock< std::mutex > lock_;
+		};
+
+		/// \brief A replaced configuration
+		struct retired_config{
+			/// \brief The configuration
+			std::unique_ptr< configuration const > config;
+
+			/// \brief global_epoch after the replacement
+			std::uint64_t epoch;
+		};
+
+		/// \brief Replaced configurations, writer_mutex() must be locked
+		std::vector< retired_config >& retired_configs(){
+			static auto const configs = new std::vector< retired_config >;
+			return *configs;
+		}
+
+		/// \brief Configurations without readers
+		using garbage = std::vector< std::unique_ptr< configuration const > >;
+
+		/// \brief Take the replaced configurations that no thread reads,
+		///        writer_mutex() must be locked
+		///
+		/// A reader that might still use a configuration entered its read
+		/// section before the replacement, so its epoch is older.
+		garbage collect(){
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			auto oldest = std::numeric_limits< std::uint64_t >::max();
+			for(auto i = slots.load(); i != nullptr; i = i->next){
+				auto const epoch = i->epoch.load(std::memory_order_acquire);
+				if(epoch != 0) oldest = std::min(oldest, epoch);
+			}
+
+			garbage result;
+			auto& retired = retired_configs();
+			auto const end = std::partition(retired.begin(), retired.end(),
+				[oldest](retired_config const& r){ return r.epoch > oldest; });
+			for(auto i = end; i != retired.end(); ++i){
+				result.push_back(std::move(i->config));
+			}
+			retired.erase(end, retired.end());
+			reclaim_pending = !retired.empty();
+			return result;
+		}
+
+		/// \brief Publish, writer_mutex() must be locked
+		///
+		/// \return Configurations to destroy after the unlock, so a sink
+		///         destructor can log and configure
+		garbage publish(configuration&& new_config){
+			auto& retired = retired_configs();
+			retired.reserve(retired.size() + 1);
+
+			auto const factory = new_config.factory;
+			std::unique_ptr< configuration const > old(current_config
+				.exchange(new configuration const(std::move(new_config))));
+			current_factory.store(factory, std::memory_order_release);
+			auto const epoch = ++global_epoch;
+			if(old) retired.push_back(retired_config{std::move(old), epoch});
+
+			return collect();
+		}
+
+		/// \brief Destroy configurations that are no longer read
+		void try_reclaim()noexcept try{
+			// the writer itself reads the configuration
+			if(writing) return;
+
+			garbage configs;
+			writer_lock lock(std::try_to_lock);
+			if(!lock.owns_lock()) return;
+			configs = collect();
+		}catch(...){
+			// retried by the next reader
+		}
+
+
+	}
+
+
+	config_ptr::config_ptr()noexcept{
+		auto& slot = thread_slot();
+		if(slot.depth++ == 0){
+			slot.epoch.store(global_epoch.load(std::memory_order_acquire),
+				std::memory_order_relaxed);
+			// pairs with the fence in collect()
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+		}
+		config_ = current_config.load(std::memory_order_acquire);
+		if(config_ == nullptr) config_ = default_config();
+	}
+
+	config_ptr::~config_ptr(){
+		auto& slot = thread_slot();
+		if(--slot.depth > 0) return;
+
+		slot.epoch.store(0, std::memory_order_release);
+		if(reclaim_pending.load(std::memory_order_relaxed)) try_reclaim();
+	}
+
+	void set_config(configuration new_config){
+		garbage configs;
+		writer_lock lock;
+		configs = publish(std::move(new_config));
+	}
+
+	void modify_config(std::function< void(configuration&) > const& f){
+		garbage configs;
+		writer_lock lock;
+		auto new_config = *config();
+		f(new_config);
+		configs = publish(std::move(new_config));
+	}
+
+
+	namespace detail{
+
+
+		stdlogb_factory config_factory()noexcept{
+			return current_factory.load(std::memory_order_acquire);
+		}
+
+
+	}
+
+
+}
@@ -0,0 +1,533 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/control.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+namespace logsys{
+
+
+	namespace detail{
+
+
+		bool glob_match(std::string_view pattern, std::string_view text)
+		noexcept{
+			// Iterative matching with backtracking to the last '*'
+			std::size_t p = 0;
+			std::size_t t = 0;
+			std::size_t star = std::string_view::npos;
+			std::size_t star_text = 0;
+
+			while(t < text.size()){
+				if(p < pattern.size() &&
+					(pattern[p] == '?' || pattern[p] == text[t])
+				){
+					++p;
+					++t;
+				}else if(p < pattern.size() && pattern[p] == '*'){
+					star = p++;
+					star_text = t;
+				}else if(star != std::string_view::npos){
+					p = star + 1;
+					t = ++star_text;
+				}else{
+					return false;
+				}
+			}
+
+			while(p < pattern.size() && pattern[p] == '*') ++p;
+
+			return p == pattern.size();
+		}
+
+
+	}
+
+
+	namespace{
+
+
+		/// \brief A parsed control command
+		struct command{
+			/// \brief Glob for the file name, empty matches all
+			std::string file;
+
+			/// \brief Glob for the function name, empty matches all
+			std::string function;
+
+			/// \brief First matching line
+			unsigned first_line = 0;
+
+			/// \brief Last matching line
+			unsigned last_line = static_cast< unsigned >(-1);
+
+			/// \brief Enable or disable matching sites
+			std::optional< bool > enable;
+
+			/// \brief Set level of matching sites
+			std::optional< logsys::level > level;
+
+			/// \brief Set sampling of matching sites
+			std::optional< std::uint32_t > sampling;
+
+			/// \brief Set rate limit (per second, burst) of matching sites
+			std::optional< std::pair< double, std::uint32_t > > rate_limit;
+
+
+			/// \brief true if site matches the command
+			bool match(call_site const& site)const noexcept{
+				auto const& loc = site.location();
+
+				if(loc.line < first_line || loc.line > last_line){
+					return false;
+				}
+
+				if(!file.empty()){
+					std::string_view const path(loc.file);
+					auto const pos = path.find_last_of("/\\");
+					auto const name = pos == std::string_view::npos
+						? path : path.substr(pos + 1);
+					if(
+						!detail::glob_match(file, path) &&
+						!detail::glob_match(file, name)
+					){
+						return false;
+					}
+				}
+
+				return function.empty()
+					|| detail::glob_match(function, loc.function);
+			}
+
+			/// \brief true if other matches the same sites
+			bool same_pattern(command const& other)const noexcept{
+				return file == other.file && function == other.function &&
+					first_line == other.first_line &&
+					last_line == other.last_line;
+			}
+
+			/// \brief true if the command has no action
+			bool empty()const noexcept{
+				return !enable && !level && !sampling && !rate_limit;
+			}
+
+			/// \brief Remove the actions that other sets too
+			void remove_actions_of(command const& other)noexcept{
+				if(other.enable) enable.reset();
+				if(other.level) level.reset();
+				if(other.sampling) sampling.reset();
+				if(other.rate_limit) rate_limit.reset();
+			}
+
+			/// \brief Reset the actions to the defaults of site
+			void revert(call_site& site)const noexcept{
+				if(enable) site.enable(true);
+				if(level) site.reset_level();
+				if(sampling) site.set_sampling(0);
+				if(rate_limit) site.set_rate_limit(0);
+			}
+
+			/// \brief Apply the actions to site
+			void apply(call_site& site)const noexcept{
+				if(enable) site.enable(*enable);
+				if(level) site.set_level(*level);
+				if(sampling) site.set_sampling(*sampling);
+				if(rate_limit){
+					site.set_rate_limit(rate_limit->first, rate_limit->second);
+				}
+			}
+		};
+
+
+		logsys::level parse_level(std::string_view name){
+			if(name == "trace") return logsys::level::trace;
+			if(name == "debug") return logsys::level::debug;
+			if(name == "info") return logsys::level::info;
+			if(name == "warning") return logsys::level::warning;
+			if(name == "error") return logsys::level::error;
+			throw std::invalid_argument(
+				"unknown level '" + std::string(name) + "'");
+		}
+
+		std::uint32_t parse_number(std::string const& text){
+			// from_chars accepts no sign for unsigned types
+			std::uint32_t value = 0;
+			auto const end = text.data() + text.size();
+			auto const [ptr, error] = std::from_chars(text.data(), end, value);
+			if(error != std::errc() || ptr != end){
+				throw std::invalid_argument("invalid number '" + text + "'");
+			}
+
+			return value;
+		}
+
+		std::pair< double, std::uint32_t > parse_rate_limit(
+			std::string const& text
+		){
+			auto const pos = text.find('/');
+			auto const rate = text.substr(0, pos);
+
+			std::size_t end = 0;
+			double per_second = 0;
+			try{
+				per_second = std::stod(rate, &end);
+			}catch(...){
+				end = 0;
+			}
+
+			if(
+				end != rate.size() || end == 0 ||
+				!std::isfinite(per_second) || per_second < 0
+			){
+				throw std::invalid_argument(
+					"invalid rate limit '" + text + "'");
+			}
+
+			auto const burst = pos == std::string::npos
+				? 1u : parse_number(text.substr(pos + 1));
+			return {per_second, burst};
+		}
+
+		command parse_command(std::string_view text){
+			std::istringstream is{std::string(text)};
+
+			auto const next = [&is](char const* keyword){
+					std::string result;
+					if(!(is >> result)){
+						throw std::invalid_argument(
+							std::string("missing value after '") + keyword
+							+ "'");
+					}
+					return result;
+				};
+
+			command result;
+			bool has_action = false;
+			std::string word;
+			while(is >> word){
+				if(word == "file"){
+					result.file = next("file");
+				}else if(word == "func"){
+					result.function = next("func");
+				}else if(word == "line"){
+					auto const range = next("line");
+					auto const pos = range.find('-');
+					result.first_line = parse_number(range.substr(0, pos));
+					result.last_line = pos == std::string::npos
+						? result.first_line
+						: parse_number(range.substr(pos + 1));
+				}else if(word == "+p"){
+					result.enable = true;
+					has_action = true;
+				}else if(word == "-p"){
+					result.enable = false;
+					has_action = true;
+				}else if(word.compare(0, 6, "level=") == 0){
+					result.level = parse_level(
+						std::string_view(word).substr(6));
+					has_action = true;
+				}else if(word.compare(0, 7, "sample=") == 0){
+					result.sampling = parse_number(word.substr(7));
+					has_action = true;
+				}else if(word.compare(0, 10, "ratelimit=") == 0){
+					result.rate_limit = parse_rate_limit(word.substr(10));
+					has_action = true;
+				}else{
+					throw std::invalid_argument(
+						"unknown keyword '" + word + "'");
+				}
+			}
+
+			if(!has_action){
+				throw std::invalid_argument("command without action");
+			}
+
+			return result;
+		}
+
+
+		/// \brief Remembered commands for call sites registered later
+		///
+		/// The commands of the control file are applied first, the commands
+		/// of control() override them.
+		class command_store{
+		public:
+			/// \brief Add a command of control()
+			///
+			/// Actions of older commands with the same pattern that c
+			/// overrides are removed, so repeated commands do not pile up.
+			std::size_t add(command const& c){
+				std::lock_guard< std::mutex > lock(mutex_);
+				for(auto& old: commands_){
+					if(old.same_pattern(c)) old.remove_actions_of(c);
+				}
+				commands_.erase(std::remove_if(commands_.begin(),
+					commands_.end(), [](command const& old){
+						return old.empty();
+					}), commands_.end());
+				commands_.push_back(c);
+
+				detail::call_site_hook.store(&hook);
+				std::size_t count = 0;
+				for_each_call_site([&c, &count](call_site& site){
+						if(!c.match(site)) return;
+						c.apply(site);
+						++count;
+					});
+				return count;
+			}
+
+			/// \brief Replace all commands of the control file
+			///
+			/// The actions of the old file commands are reset to their
+			/// defaults, so removed lines are reverted. The sites matched by
+			/// the old or the new file commands get all commands again.
+			/// Other sites keep the state set by the call_site API.
+			void set_file_commands(std::vector< command > list){
+				std::lock_guard< std::mutex > lock(mutex_);
+				auto const old = std::exchange(file_commands_, std::move(list));
+
+				detail::call_site_hook.store(&hook);
+				for_each_call_site([this, &old](call_site& site){
+						bool matched = false;
+						for(auto const& c: old){
+							if(!c.match(site)) continue;
+							c.revert(site);
+							matched = true;
+						}
+						for(auto const& c: file_commands_){
+							matched = matched || c.match(site);
+						}
+						if(matched) apply_locked(site);
+					});
+			}
+
+			/// \brief Apply all commands to a new site
+			void apply(call_site& site)noexcept{
+				std::lock_guard< std::mutex > lock(mutex_);
+				apply_locked(site);
+			}
+
+		private:
+			/// \brief Apply all commands to site, mutex_ is locked
+			void apply_locked(call_site& site)const noexcept{
+				for(auto const& c: file_commands_){
+					if(c.match(site)) c.apply(site);
+				}
+				for(auto const& c: commands_){
+					if(c.match(site)) c.apply(site);
+				}
+			}
+
+			static void hook(call_site& site)noexcept;
+
+			/// \brief Guards the commands
+			std::mutex mutex_;
+
+			/// \brief Commands of the control file
+			std::vector< command > file_commands_;
+
+			/// \brief Commands of control()
+			std::vector< command > commands_;
+		};
+
+		command_store& store(){
+			static command_store instance;
+			return instance;
+		}
+
+		void command_store::hook(call_site& site)noexcept{
+			store().apply(site);
+		}
+
+
+		/// \brief Parse all lines of a control file
+		std::vector< command > read_control_file(std::string const& filename){
+			std::ifstream is(filename);
+			if(!is.is_open()){
+				throw std::runtime_error(
+					"can not open control file: " + filename);
+			}
+
+			std::vector< command > result;
+			std::string line;
+			for(std::size_t number = 1; std::getline(is, line); ++number){
+				auto const pos = line.find_first_not_of(" \t\r");
+				if(pos == std::string::npos || line[pos] == '#') continue;
+
+				try{
+					result.push_back(parse_command(line));
+				}catch(std::exception const& e){
+					std::cerr << "logsys control file " << filename << ':'
+						<< number << ": " << e.what() << '\n';
+				}
+			}
+
+			return result;
+		}
+
+
+		/// \brief Thread that re-reads the control file on change
+		class file_watcher{
+		public:
+			/// \brief Start watching
+			explicit file_watcher(std::string const& filename);
+
+			/// \brief Stop watching
+			~file_watcher();
+
+		private:
+#ifdef __linux__
+			/// \brief Wait for changes until stop_fd_ is signaled
+			void run()noexcept;
+
+			/// \brief The watched file
+			std::string const filename_;
+
+			/// \brief Name of the file without directory
+			std::string name_;
+
+			/// \brief inotify file descriptor
+			int inotify_fd_ = -1;
+
+			/// \brief eventfd to stop the thread
+			int stop_fd_ = -1;
+
+			/// \brief The watching thread
+			std::thread thread_;
+#endif
+		};
+
+#ifdef __linux__
+		file_watcher::file_watcher(std::string const& filename)
+			: filename_(filename)
+		{
+			auto const pos = filename.find_last_of('/');
+			auto const dir = pos == std::string::npos
+				? std::string(".") : filename.substr(0, pos + 1);
+			name_ = pos == std::string::npos
+				? filename : filename.substr(pos + 1);
+
+			inotify_fd_ = inotify_init1(IN_CLOEXEC);
+			stop_fd_ = eventfd(0, EFD_CLOEXEC);
+			if(inotify_fd_ < 0 || stop_fd_ < 0 || inotify_add_watch(
+					inotify_fd_, dir.c_str(),
+					IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0
+			){
+				if(inotify_fd_ >= 0) close(inotify_fd_);
+				if(stop_fd_ >= 0) close(stop_fd_);
+				throw std::runtime_error(
+					"can not watch control file: " + filename);
+			}
+
+			thread_ = std::thread([this]{ run(); });
+		}
+
+		file_watcher::~file_watcher(){
+			std::uint64_t const value = 1;
+			(void)!::write(stop_fd_, &value, sizeof(value));
+			thread_.join();
+			close(inotify_fd_);
+			close(stop_fd_);
+		}
+
+		void file_watcher::run()noexcept{
+			alignas(inotify_event) char buffer[4096];
+			pollfd fds[2] = {
+					{inotify_fd_, POLLIN, 0},
+					{stop_fd_, POLLIN, 0}
+				};
+
+			for(;;){
+				if(poll(fds, 2, -1) < 0) continue;
+				if(fds[1].revents != 0) return;
+				if(fds[0].revents == 0) continue;
+
+				auto const size = read(inotify_fd_, buffer, sizeof(buffer));
+				if(size <= 0) continue;
+
+				bool changed = false;
+				for(auto pos = 0l; pos < size;){
+					auto const& event =
+						*reinterpret_cast< inotify_event const* >(buffer + pos);
+					if(event.len > 0 && name_ == event.name) changed = true;
+					pos += sizeof(inotify_event) + event.len;
+				}
+
+				if(!changed) continue;
+
+				try{
+					store().set_file_commands(
+						read_control_file(filename_));
+				}catch(std::exception const& e){
+					std::cerr << "logsys: " << e.what() << '\n';
+				}
+			}
+		}
+#else
+		file_watcher::file_watcher(std::string const&){}
+
+		file_watcher::~file_watcher(){}
+#endif
+
+
+		/// \brief Guards the watcher
+		std::mutex& watcher_mutex(){
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		/// \brief The active watcher
+		std::unique_ptr< file_watcher >& watcher(){
+			static std::unique_ptr< file_watcher > instance;
+			return instance;
+		}
+
+
+	}
+
+
+	std::size_t control(std::string_view command){
+		return store().add(parse_command(command));
+	}
+
+	void watch_control_file(std::string const& filename){
+		std::lock_guard< std::mutex > lock(watcher_mutex());
+		watcher().reset();
+		store().set_file_commands(read_control_file(filename));
+		watcher() = std::make_unique< file_watcher >(filename);
+	}
+
+	void unwatch_control_file(){
+		std::lock_guard< std::mutex > lock(watcher_mutex());
+		watcher().reset();
+		store().set_file_commands({});
+	}
+
+
+}
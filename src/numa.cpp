@@ -0,0 +1,137 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/backend.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+namespace logsys::detail{
+
+
+	std::vector< int > parse_cpu_list(std::string_view list){
+		std::vector< int > result;
+
+		auto const parse = [](std::string_view text, int& value){
+				auto const end = text.data() + text.size();
+				auto const r = std::from_chars(text.data(), end, value);
+				return r.ec == std::errc() && r.ptr == end && value >= 0;
+			};
+
+		while(!list.empty()){
+			auto const comma = list.find(',');
+			auto item = list.substr(0, comma);
+			list.remove_prefix(
+				comma == std::string_view::npos ? list.size() : comma + 1);
+
+			while(!item.empty() && std::isspace(
+				static_cast< unsigned char >(item.back()))
+			) item.remove_suffix(1);
+			if(item.empty()) continue;
+
+			auto const dash = item.find('-');
+			int first;
+			int last;
+			if(dash == std::string_view::npos){
+				if(!parse(item, first)) return {};
+				last = first;
+			}else if(
+				!parse(item.substr(0, dash), first) ||
+				!parse(item.substr(dash + 1), last) ||
+				last < first
+			){
+				return {};
+			}
+
+			for(int cpu = first; cpu <= last; ++cpu) result.push_back(cpu);
+		}
+
+		return result;
+	}
+
+	std::vector< std::vector< int > > sysfs_numa_nodes(
+		std::string const& dir
+	){
+		auto const read_list = [](std::string const& path){
+				std::ifstream is(path);
+				std::string list;
+				std::getline(is, list);
+				return parse_cpu_list(list);
+			};
+
+		// node numbers can have gaps, e.g. "0,2-3"
+		std::vector< std::vector< int > > nodes;
+		for(auto const node: read_list(dir + "/online")){
+			nodes.push_back(read_list(
+				dir + "/node" + std::to_string(node) + "/cpulist"));
+		}
+		return nodes;
+	}
+
+	std::vector< std::vector< int > > numa_nodes(std::size_t simulated){
+		std::vector< std::vector< int > > nodes;
+
+		if(simulated == 0){
+			nodes = sysfs_numa_nodes("/sys/devices/system/node");
+			if(!nodes.empty()) return nodes;
+			simulated = 1;
+		}
+
+		// split the CPUs into simulated nodes of neighboring CPUs
+		auto const cpus = static_cast< std::size_t >(
+			std::max(std::thread::hardware_concurrency(), 1u));
+		nodes.resize(simulated);
+		for(std::size_t cpu = 0; cpu < cpus; ++cpu){
+			nodes[cpu * simulated / cpus].push_back(static_cast< int >(cpu));
+		}
+		return nodes;
+	}
+
+	std::size_t current_node(
+		std::vector< std::vector< int > > const& nodes
+	)noexcept{
+#ifdef __linux__
+		auto const cpu = sched_getcpu();
+		for(std::size_t i = 0; i < nodes.size(); ++i){
+			auto const& node = nodes[i];
+			if(std::find(node.begin(), node.end(), cpu) != node.end()){
+				return i;
+			}
+		}
+#endif
+		return 0;
+	}
+
+	bool pin_thread(std::thread& thread, std::vector< int > const& cpus)
+	noexcept{
+		if(cpus.empty()) return true;
+#ifdef __linux__
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for(auto const cpu: cpus){
+			if(cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+		}
+		return pthread_setaffinity_np(thread.native_handle(),
+			sizeof(set), &set) == 0;
+#else
+		return false;
+#endif
+	}
+
+
+}
@@ -0,0 +1,144 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/detail/page_buffer.hpp>
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+namespace logsys::detail{
+
+
+	namespace{
+
+
+		/// \brief Round size up to a multiple of page
+		std::size_t round_up(std::size_t size, std::size_t page)noexcept{
+			return (size + page - 1) / page * page;
+		}
+
+
+	}
+
+
+	page_buffer::page_buffer(
+		std::size_t size,
+		huge_pages pages,
+		bool prefault,
+		bool lock
+	){
+		if(size == 0) size = 1;
+
+#ifdef __linux__
+		auto const page = static_cast< std::size_t >(::sysconf(_SC_PAGESIZE));
+		auto const flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+		if(pages == huge_pages::hugetlb){
+			size_ = round_up(size, huge_page_size);
+			data_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+				flags | MAP_HUGETLB, -1, 0);
+			huge_ = data_ != MAP_FAILED;
+		}
+
+		if(pages == huge_pages::transparent){
+			// map one huge page more to align the begin
+			size_ = round_up(size, huge_page_size);
+			auto const raw = ::mmap(nullptr, size_ + huge_page_size,
+				PROT_READ | PROT_WRITE, flags, -1, 0);
+			if(raw != MAP_FAILED){
+				auto const begin = reinterpret_cast< std::uintptr_t >(raw);
+				auto const aligned = round_up(begin, huge_page_size);
+				auto const front = aligned - begin;
+				if(front > 0) ::munmap(raw, front);
+				auto const back = huge_page_size - front;
+				if(back > 0){
+					::munmap(reinterpret_cast< char* >(aligned) + size_, back);
+				}
+				data_ = reinterpret_cast< void* >(aligned);
+#ifdef MADV_HUGEPAGE
+				huge_ = ::madvise(data_, size_, MADV_HUGEPAGE) == 0;
+#endif
+			}
+		}
+
+		if(!huge_ && (data_ == nullptr || data_ == MAP_FAILED)){
+			size_ = round_up(size, page);
+			data_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, flags,
+				-1, 0);
+			if(data_ == MAP_FAILED){
+				data_ = nullptr;
+				size_ = 0;
+				throw std::bad_alloc();
+			}
+		}
+
+		if(prefault){
+			// transparent huge pages may fall back to normal pages, only
+			// hugetlb mappings are faulted per huge page
+			auto const hugetlb = huge_ && pages == huge_pages::hugetlb;
+			auto const step = hugetlb ? huge_page_size : page;
+			auto const bytes = static_cast< char volatile* >(data_);
+			for(std::size_t i = 0; i < size_; i += step) bytes[i] = 0;
+		}
+
+		if(lock){
+			locked_ = ::mlock(data_, size_) == 0;
+		}
+#else
+		(void)pages;
+		(void)prefault;
+		(void)lock;
+		size_ = size;
+		data_ = ::operator new(size_);
+#endif
+	}
+
+	page_buffer::page_buffer(page_buffer&& other)noexcept:
+		data_(std::exchange(other.data_, nullptr)),
+		size_(std::exchange(other.size_, 0)),
+		huge_(std::exchange(other.huge_, false)),
+		locked_(std::exchange(other.locked_, false)) {}
+
+	page_buffer& page_buffer::operator=(page_buffer&& other)noexcept{
+		if(this != &other){
+			release();
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+			huge_ = std::exchange(other.huge_, false);
+			locked_ = std::exchange(other.locked_, false);
+		}
+		return *this;
+	}
+
+	page_buffer::~page_buffer(){
+		release();
+	}
+
+	void page_buffer::release()noexcept{
+		if(data_ == nullptr) return;
+#ifdef __linux__
+		if(locked_) ::munlock(data_, size_);
+		::munmap(data_, size_);
+#else
+		::operator delete(data_);
+#endif
+		data_ = nullptr;
+		size_ = 0;
+		huge_ = false;
+		locked_ = false;
+	}
+
+
+}
@@ -0,0 +1,146 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/retain.hpp>
+#include <logsys/config.hpp>
+#include <logsys/stdlog.hpp>
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace logsys::detail{
+
+
+	namespace{
+
+
+		/// \brief An unformatted record in the arena
+		struct retained_record{
+			/// \brief Meta data of the record
+			record_info info;
+
+			/// \brief Begin of the message in the arena text
+			std::size_t offset;
+
+			/// \brief Length of the message
+			std::size_t size;
+
+			/// \brief Exception throw in body function
+			std::exception_ptr body_exception;
+
+			/// \brief Exception throw in log function
+			std::exception_ptr log_exception;
+		};
+
+
+		/// \brief Retained records of a thread
+		///
+		/// Both vectors keep their capacity, so once warmed up, retaining a
+		/// record is appending without allocation.
+		struct retention_arena{
+			/// \brief Messages of all records
+			std::string text;
+
+			/// \brief The records
+			std::vector< retained_record > records;
+
+			/// \brief Number of open retention scopes
+			std::size_t depth = 0;
+
+
+			/// \brief Remove all records since mark
+			void truncate(std::size_t mark)noexcept{
+				if(mark >= records.size()) return;
+				text.resize(records[mark].offset);
+				records.resize(mark);
+			}
+		};
+
+		retention_arena& this_thread_arena()noexcept{
+			thread_local retention_arena arena;
+			return arena;
+		}
+
+
+		/// \brief Output all records since mark to the sinks
+		void output(retention_arena const& arena, std::size_t mark){
+			auto const c = config();
+			for(auto i = mark; i < arena.records.size(); ++i){
+				auto const& r = arena.records[i];
+				c->sinks.dispatch(r.info, [&arena, &r]{
+						auto const text = std::string_view(arena.text);
+						return stdlog::make_log_line(r.info,
+							text.substr(r.offset, r.size),
+							r.body_exception, r.log_exception);
+					});
+			}
+		}
+
+
+	}
+
+
+	std::size_t retention_begin()noexcept{
+		auto& arena = this_thread_arena();
+		++arena.depth;
+		return arena.records.size();
+	}
+
+	void retention_end(std::size_t mark, bool failed)noexcept{
+		auto& arena = this_thread_arena();
+		--arena.depth;
+
+		if(!failed){
+			arena.truncate(mark);
+			return;
+		}
+
+		// The enclosing scope decides about the records
+		if(arena.depth > 0) return;
+
+		try{
+			output(arena, mark);
+		}catch(std::exception const& e){
+			std::cerr << "retained records lost by exception: "
+				<< e.what() << std::endl;
+		}catch(...){
+			std::cerr << "retained records lost by unknown exception"
+				<< std::endl;
+		}
+
+		arena.truncate(mark);
+	}
+
+	bool retain(
+		record_info const& info,
+		std::string_view message,
+		std::exception_ptr body_exception,
+		std::exception_ptr log_exception
+	){
+		auto& arena = this_thread_arena();
+		if(arena.depth == 0) return false;
+
+		auto const offset = arena.text.size();
+		arena.text.append(message.data(), message.size());
+		try{
+			arena.records.push_back(retained_record{info, offset,
+				message.size(), std::move(body_exception),
+				std::move(log_exception)});
+		}catch(...){
+			arena.text.resize(offset);
+			throw;
+		}
+
+		return true;
+	}
+
+
+}
@@ -0,0 +1,588 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/rtlog.hpp>
+#include <logsys/stdlog.hpp>
+#include <logsys/signal_log.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+
+namespace logsys{
+
+
+	namespace{
+
+
+		/// \brief A record in the ring
+		struct rt_slot{
+			/// \brief Meta data of the record
+			record_info info;
+
+			/// \brief Exception throw in body function
+			std::exception_ptr body_exception;
+
+			/// \brief Exception throw in log function
+			std::exception_ptr log_exception;
+
+			/// \brief Length of the message text
+			std::uint16_t size;
+
+			/// \brief true if the message text was truncated
+			bool truncated;
+
+			/// \brief The message text
+			char text[detail::rt_text_size];
+		};
+
+		static_assert(detail::rt_text_size <= UINT16_MAX);
+
+
+		/// \brief Wait-free ring of a single real time producer
+		///
+		/// The memory is allocated and prefaulted in the constructor. Slots
+		/// between head and tail hold constructed records.
+		class rt_ring{
+		public:
+			/// \brief Allocate room for at least options.capacity records
+			explicit rt_ring(rtlog_options const& options):
+				memory_(std::max< std::size_t >(options.capacity, 1)
+					* sizeof(rt_slot), options.pages, true,
+					options.lock_memory),
+				capacity_(memory_.size() / sizeof(rt_slot)),
+				slots_(static_cast< rt_slot* >(memory_.data())) {}
+
+			rt_ring(rt_ring const&) = delete;
+
+			rt_ring& operator=(rt_ring const&) = delete;
+
+			/// \brief Destroy the remaining records
+			~rt_ring(){
+				drain([](rt_slot const&){});
+			}
+
+
+			/// \brief Producer: append a record, false if the ring is full
+			bool push(
+				record_info const& info,
+				std::string_view message,
+				bool truncated,
+				std::exception_ptr const& body_exception,
+				std::exception_ptr const& log_exception
+			)noexcept{
+				auto const tail = tail_.load(std::memory_order_relaxed);
+				if(tail - head_.load(std::memory_order_acquire) == capacity_){
+					dropped_.store(dropped_.load(std::memory_order_relaxed) + 1,
+						std::memory_order_relaxed);
+					return false;
+				}
+
+				auto const size =
+					std::min(message.size(), detail::rt_text_size);
+				auto const s = new(slots_ + tail % capacity_) rt_slot{info,
+					body_exception, log_exception,
+					static_cast< std::uint16_t >(size),
+					truncated || size < message.size(), {}};
+				std::memcpy(s->text, message.data(), size);
+				tail_.store(tail + 1, std::memory_order_release);
+				return true;
+			}
+
+			/// \brief Consumer: call f for every queued record and remove it
+			///
+			/// Without Destroy the records are not destructed, which
+			/// never calls free().
+			template < bool Destroy = true, typename F >
+			void drain(F&& f){
+				auto head = head_.load(std::memory_order_relaxed);
+				auto const tail = tail_.load(std::memory_order_acquire);
+				for(; head != tail; ++head){
+					auto& s = slots_[head % capacity_];
+					f(static_cast< rt_slot const& >(s));
+					if constexpr(Destroy) s.~rt_slot();
+					head_.store(head + 1, std::memory_order_release);
+				}
+			}
+
+
+			/// \brief Count of records ever stored
+			std::size_t posted()const noexcept{
+				return tail_.load(std::memory_order_relaxed);
+			}
+
+			/// \brief Count of records lost by a full ring
+			std::size_t dropped()const noexcept{
+				return dropped_.load(std::memory_order_relaxed);
+			}
+
+			/// \brief Bytes of the ring memory
+			std::size_t memory_size()const noexcept{
+				return memory_.size();
+			}
+
+
+			/// \brief Set when the producer thread ended or prepared a new
+			///        ring
+			std::atomic< bool > orphaned{false};
+
+
+		private:
+			/// \brief The memory
+			detail::page_buffer memory_;
+
+			/// \brief Count of slots
+			std::size_t const capacity_;
+
+			/// \brief The records
+			rt_slot* const slots_;
+
+			/// \brief Next record to read, written by the consumer
+			alignas(64) std::atomic< std::size_t > head_{0};
+
+			/// \brief Next record to write, written by the producer
+			alignas(64) std::atomic< std::size_t > tail_{0};
+
+			/// \brief Records lost by a full ring, written by the producer
+			std::atomic< std::size_t > dropped_{0};
+		};
+
+
+		/// \brief Ring of the calling thread, nullptr if not prepared
+		///
+		/// Trivial, so the first access by a thread doesn't register a
+		/// destructor, which could allocate.
+		thread_local rt_ring* local_ring = nullptr;
+
+		/// \brief Records lost by threads without a ring
+		std::atomic< std::size_t > dropped_unprepared(0);
+
+
+		static_assert(std::atomic< std::size_t >::is_always_lock_free,
+			"flush_rtlog_from_signal() requires lock-free ring indices");
+
+
+		/// \brief Owner of the calling thread's ring
+		struct rt_ring_handle{
+			/// \brief Mark the ring for reclamation by flush_rtlog()
+			~rt_ring_handle(){
+				local_ring = nullptr;
+				if(ring) ring->orphaned = true;
+			}
+
+			std::shared_ptr< rt_ring > ring;
+		};
+
+
+		class rt_registry;
+
+		/// \brief The registry for signal handlers, nullptr if not alive
+		std::atomic< rt_registry* > registry_instance(nullptr);
+
+
+		/// \brief Holds an atomic_flag set for its lifetime
+		struct flag_guard{
+			explicit flag_guard(std::atomic_flag& flag)noexcept:
+				flag(flag)
+			{
+				while(flag.test_and_set(std::memory_order_acquire)){
+					std::this_thread::yield();
+				}
+			}
+
+			~flag_guard(){
+				flag.clear(std::memory_order_release);
+			}
+
+			std::atomic_flag& flag;
+		};
+
+
+		/// \brief The rings and the writer thread
+		class rt_registry{
+		public:
+			/// \brief Register the fork handlers
+			rt_registry()noexcept{
+				registry_instance = this;
+#ifdef __linux__
+				static bool const registered = []{
+						pthread_atfork(
+							[]{ with_instance(&rt_registry::prepare_fork); },
+							[]{ with_instance(
+								&rt_registry::parent_after_fork); },
+							[]{ with_instance(
+								&rt_registry::child_after_fork); });
+						return true;
+					}();
+				(void)registered;
+#endif
+			}
+
+			/// \brief Output everything on program exit
+			~rt_registry(){
+				stop_writer();
+				registry_instance = nullptr;
+			}
+
+
+			/// \brief Create a new ring for the calling thread
+			void prepare(rtlog_options const& options){
+				thread_local rt_ring_handle handle;
+
+				auto ring = std::make_shared< rt_ring >(options);
+				{
+					std::lock_guard< std::mutex > lock(mutex_);
+					flag_guard guard(busy_);
+					rings_.push_back(ring);
+				}
+
+				if(handle.ring) handle.ring->orphaned = true;
+				handle.ring = std::move(ring);
+				local_ring = handle.ring.get();
+			}
+
+			/// \brief Output the records of all rings in the order of time
+			std::size_t flush()noexcept try{
+				std::lock_guard< std::mutex > lock(mutex_);
+
+				pending_.clear();
+				{
+					flag_guard guard(busy_);
+					for(auto i = rings_.begin(); i != rings_.end();){
+						auto& ring = **i;
+						auto const orphaned = ring.orphaned.load();
+						ring.drain([this](rt_slot const& s){
+								pending_.push_back(entry{s.info,
+									std::string(s.text, s.size), s.truncated,
+									s.body_exception, s.log_exception});
+							});
+
+						if(orphaned){
+							posted_ += ring.posted();
+							dropped_full_ += ring.dropped();
+							i = rings_.erase(i);
+						}else{
+							++i;
+						}
+					}
+				}
+
+				std::stable_sort(pending_.begin(), pending_.end(),
+					[](entry const& a, entry const& b){
+						return a.time() < b.time();
+					});
+
+				for(auto const& e: pending_){
+					std::clog << stdlog::make_log_line(e.info,
+						e.truncated ? e.message + "..." : e.message,
+						e.body_exception, e.log_exception);
+				}
+
+				auto const count = pending_.size();
+				written_ += count;
+				pending_.clear();
+				return count;
+			}catch(std::exception const& e){
+				std::cerr << "real time log records lost by exception: "
+					<< e.what() << std::endl;
+				return 0;
+			}catch(...){
+				std::cerr << "real time log records lost by unknown exception"
+					<< std::endl;
+				return 0;
+			}
+
+			/// \brief Output the records of all rings by
+			///        detail::signal_write_record()
+			///
+			/// The records are output ring by ring, not in the order of time.
+			std::size_t flush_from_signal(int fd)noexcept{
+				if(busy_.test_and_set(std::memory_order_acquire)) return 0;
+
+				std::size_t count = 0;
+				for(auto const& ring: rings_){
+					ring->drain< false >([fd, &count](rt_slot const& s){
+							detail::signal_write_record(fd, s.info,
+								std::string_view(s.text, s.size), s.truncated);
+							++count;
+						});
+				}
+				signal_written_.fetch_add(count, std::memory_order_relaxed);
+
+				busy_.clear(std::memory_order_release);
+				return count;
+			}
+
+			rtlog_counters statistics()noexcept{
+				std::lock_guard< std::mutex > lock(mutex_);
+				rtlog_counters result;
+				result.posted = posted_;
+				result.dropped_full = dropped_full_;
+				for(auto const& ring: rings_){
+					result.posted += ring->posted();
+					result.dropped_full += ring->dropped();
+					result.ring_bytes += ring->memory_size();
+				}
+				result.dropped_unprepared = dropped_unprepared.load();
+				result.written = written_ + signal_written_.load();
+				return result;
+			}
+
+
+			void start_writer(std::chrono::milliseconds interval){
+				std::lock_guard< std::mutex > control_lock(control_mutex_);
+				start_writer_locked(interval);
+			}
+
+			void stop_writer()noexcept{
+				std::lock_guard< std::mutex > control_lock(control_mutex_);
+				stop_writer_locked();
+			}
+
+
+		private:
+			/// \brief Start the writer, control_mutex_ is locked
+			void start_writer_locked(std::chrono::milliseconds interval){
+				{
+					std::lock_guard< std::mutex > lock(writer_mutex_);
+					interval_ = interval;
+					stop_ = false;
+				}
+				if(!writer_.joinable()){
+					writer_ = std::thread([this]{ run(); });
+				}
+			}
+
+			/// \brief Stop the writer and flush, control_mutex_ is locked
+			void stop_writer_locked()noexcept{
+				{
+					std::lock_guard< std::mutex > lock(writer_mutex_);
+					stop_ = true;
+				}
+				writer_cv_.notify_all();
+				if(writer_.joinable()) writer_.join();
+				flush();
+			}
+
+
+			/// \brief Call f on the living registry
+			static void with_instance(void(rt_registry::*f)()noexcept)
+			noexcept{
+				if(auto const instance = registry_instance.load()){
+					(instance->*f)();
+				}
+			}
+
+			/// \brief Before fork(): output all records and hold all locks
+			void prepare_fork()noexcept{
+				control_mutex_.lock();
+				fork_writer_ = writer_.joinable();
+				stop_writer_locked();
+
+				mutex_.lock();
+				while(busy_.test_and_set(std::memory_order_acquire)){
+					std::this_thread::yield();
+				}
+			}
+
+			/// \brief After fork() in the parent: continue as before
+			void parent_after_fork()noexcept{
+				busy_.clear(std::memory_order_release);
+				mutex_.unlock();
+				restart_writer();
+				control_mutex_.unlock();
+			}
+
+			/// \brief After fork() in the child: forget the other threads
+			///
+			/// Only the forking thread exists in the child, its ring is
+			/// kept. Records that other threads queued after the flush in
+			/// prepare_fork() are output by the parent only.
+			void child_after_fork()noexcept{
+				busy_.clear(std::memory_order_release);
+				mutex_.unlock();
+
+				for(auto i = rings_.begin(); i != rings_.end();){
+					if(i->get() == local_ring){
+						++i;
+						continue;
+					}
+
+					posted_ += (*i)->posted();
+					dropped_full_ += (*i)->dropped();
+					i = rings_.erase(i);
+				}
+
+				restart_writer();
+				control_mutex_.unlock();
+			}
+
+			/// \brief Restart the writer if it ran before fork()
+			void restart_writer()noexcept try{
+				if(fork_writer_) start_writer_locked(interval_);
+			}catch(std::exception const& e){
+				std::cerr << "logsys rtlog writer not restarted after fork: "
+					<< e.what() << std::endl;
+			}catch(...){
+				std::cerr << "logsys rtlog writer not restarted after fork"
+					<< std::endl;
+			}
+
+
+			/// \brief A record taken from a ring
+			struct entry{
+				record_info info;
+				std::string message;
+				bool truncated;
+				std::exception_ptr body_exception;
+				std::exception_ptr log_exception;
+
+				/// \brief End of the body or creation if there is no body
+				std::chrono::system_clock::time_point time()const noexcept{
+					return info.body == body_state::none ? info.start : info.end;
+				}
+			};
+
+
+			/// \brief The writer thread
+			void run(){
+				std::unique_lock< std::mutex > lock(writer_mutex_);
+				while(!stop_){
+					lock.unlock();
+					flush();
+					lock.lock();
+					if(!stop_) writer_cv_.wait_for(lock, interval_);
+				}
+			}
+
+
+			/// \brief Protects the rings, the counters and the output
+			std::mutex mutex_;
+
+			/// \brief Rings of all prepared threads
+			std::vector< std::shared_ptr< rt_ring > > rings_;
+
+			/// \brief Records of the current flush
+			std::vector< entry > pending_;
+
+			/// \brief Posted records of reclaimed rings
+			std::size_t posted_ = 0;
+
+			/// \brief Dropped records of reclaimed rings
+			std::size_t dropped_full_ = 0;
+
+			/// \brief Output records
+			std::size_t written_ = 0;
+
+			/// \brief Records output by flush_from_signal()
+			std::atomic< std::size_t > signal_written_{0};
+
+			/// \brief Set while rings_ is changed or read by a consumer
+			///
+			/// A signal handler can not wait for a mutex, it gives up if the
+			/// flag is set.
+			std::atomic_flag busy_ = ATOMIC_FLAG_INIT;
+
+
+			/// \brief Serializes start_writer() and stop_writer()
+			std::mutex control_mutex_;
+
+			/// \brief Protects interval_ and stop_
+			std::mutex writer_mutex_;
+
+			/// \brief Wakes the writer on stop
+			std::condition_variable writer_cv_;
+
+			/// \brief Time between two flushes of the writer
+			std::chrono::milliseconds interval_{10};
+
+			/// \brief Set to end the writer
+			bool stop_ = false;
+
+			/// \brief true if the writer ran before fork()
+			bool fork_writer_ = false;
+
+			/// \brief The writer thread
+			std::thread writer_;
+		};
+
+
+		rt_registry& the_registry(){
+			static rt_registry instance;
+			return instance;
+		}
+
+
+	}
+
+
+	void prepare_rt_thread(rtlog_options const& options){
+		the_registry().prepare(options);
+	}
+
+	std::size_t flush_rtlog()noexcept{
+		return the_registry().flush();
+	}
+
+	void start_rtlog_writer(std::chrono::milliseconds interval){
+		the_registry().start_writer(interval);
+	}
+
+	void stop_rtlog_writer()noexcept{
+		the_registry().stop_writer();
+	}
+
+	rtlog_counters rtlog_statistics()noexcept{
+		return the_registry().statistics();
+	}
+
+	std::size_t flush_rtlog_from_signal(int fd)noexcept{
+		auto const registry = registry_instance.load();
+		return registry != nullptr ? registry->flush_from_signal(fd) : 0;
+	}
+
+
+	namespace detail{
+
+
+		bool rt_post(
+			record_info const& info,
+			std::string_view message,
+			bool truncated,
+			std::exception_ptr const& body_exception,
+			std::exception_ptr const& log_exception
+		)noexcept{
+			auto const ring = local_ring;
+			if(ring == nullptr){
+				dropped_unprepared.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			return ring->push(info, message, truncated, body_exception,
+				log_exception);
+		}
+
+
+	}
+
+
+}
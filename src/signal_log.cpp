@@ -0,0 +1,198 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/signal_log.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <time.h>
+#include <unistd.h>
+
+
+namespace logsys{
+
+
+	namespace{
+
+
+		/// \brief A line in a stack buffer, longer text is truncated
+		class line_buffer{
+		public:
+			/// \brief Append text
+			void append(std::string_view text)noexcept{
+				auto const count = std::min(text.size(), capacity - size_);
+				std::memcpy(data_ + size_, text.data(), count);
+				size_ += count;
+			}
+
+			/// \brief Append an integer right aligned in width characters
+			template < typename T >
+			void append(T value, char fill, std::size_t width)noexcept{
+				detail::number_chars< T > text(value);
+				for(auto i = text.view().size(); i < width; ++i){
+					append(std::string_view(&fill, 1));
+				}
+				append(text.view());
+			}
+
+			/// \brief Append message, ... if truncated and a line break
+			void finish(std::string_view message, bool truncated)noexcept{
+				// keep room for the suffix
+				auto const room = capacity - std::min(capacity, size_ + 4);
+				append(message.substr(0, room));
+				if(truncated || room < message.size()) append("...");
+				append("\n");
+			}
+
+			/// \brief Output the line by a single write(2)
+			bool write(int fd)const noexcept{
+				auto const old_errno = errno;
+				ssize_t result;
+				do{
+					result = ::write(fd, data_, size_);
+				}while(result < 0 && errno == EINTR);
+				errno = old_errno;
+				return result >= 0;
+			}
+
+		private:
+			/// \brief Size of the buffer
+			static constexpr std::size_t capacity =
+				detail::signal_text_size + 128;
+
+			/// \brief The text
+			char data_[capacity];
+
+			/// \brief Length of the text
+			std::size_t size_ = 0;
+		};
+
+
+		/// \brief Append time as UTC in the format of stdlog
+		///
+		/// gmtime_r() and localtime_r() are not async-signal-safe, so the
+		/// date is computed here (algorithm by Howard Hinnant).
+		void append_time(
+			line_buffer& line,
+			std::chrono::system_clock::time_point time
+		)noexcept{
+			using namespace std::chrono;
+			auto const us = duration_cast< microseconds >(
+				time.time_since_epoch()).count();
+			auto const seconds = us / 1000000 - (us % 1000000 < 0 ? 1 : 0);
+			auto const fraction = us - seconds * 1000000;
+			auto const days = seconds / 86400 - (seconds % 86400 < 0 ? 1 : 0);
+			auto const day_seconds = seconds - days * 86400;
+
+			auto const z = days + 719468;
+			auto const era = (z >= 0 ? z : z - 146096) / 146097;
+			auto const doe = z - era * 146097;
+			auto const yoe =
+				(doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+			auto const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+			auto const mp = (5 * doy + 2) / 153;
+			auto const day = doy - (153 * mp + 2) / 5 + 1;
+			auto const month = mp < 10 ? mp + 3 : mp - 9;
+			auto const year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+			line.append(year, '0', 4);
+			line.append("-");
+			line.append(month, '0', 2);
+			line.append("-");
+			line.append(day, '0', 2);
+			line.append(" ");
+			line.append(day_seconds / 3600, '0', 2);
+			line.append(":");
+			line.append(day_seconds / 60 % 60, '0', 2);
+			line.append(":");
+			line.append(day_seconds % 60, '0', 2);
+			line.append(" ");
+			line.append(fraction / 1000, '0', 3);
+			line.append(".");
+			line.append(fraction % 1000, '0', 3);
+		}
+
+		/// \brief Current time by clock_gettime(), which is
+		///        async-signal-safe
+		std::chrono::system_clock::time_point now()noexcept{
+			using namespace std::chrono;
+			timespec ts{};
+			clock_gettime(CLOCK_REALTIME, &ts);
+			return system_clock::time_point(duration_cast<
+				system_clock::duration >(
+					seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec)));
+		}
+
+
+	}
+
+
+	namespace detail{
+
+
+		bool signal_write(int fd, std::string_view message, bool truncated)
+		noexcept{
+			line_buffer line;
+			line.append("------ ");
+			append_time(line, now());
+			line.append(" ( signal handler ) ");
+			line.finish(message, truncated);
+			return line.write(fd);
+		}
+
+		bool signal_write_record(
+			int fd,
+			record_info const& info,
+			std::string_view message,
+			bool truncated
+		)noexcept{
+			line_buffer line;
+			line.append(info.id, '0', 6);
+			line.append(" ");
+			append_time(line, info.start);
+
+			if(info.body != body_state::none){
+				using namespace std::chrono;
+				auto const ns = std::max< nanoseconds::rep >(0,
+					duration_cast< nanoseconds >(info.duration()).count());
+				line.append(" ( ");
+				line.append(ns / 1000000, ' ', 8);
+				line.append(".");
+				line.append(ns / 1000 % 1000, '0', 3);
+				line.append("ms ) ");
+			}else{
+				line.append(" ( no content     ) ");
+			}
+
+			if(info.log_exception){
+				line.append("LOG EXCEPTION CATCHED; ");
+			}
+
+			switch(info.body){
+				case body_state::failed_by_exception:
+					line.append("(BODY FAILED) ");
+					break;
+				case body_state::catched_exception:
+					line.append("(BODY EXCEPTION CATCHED) ");
+					break;
+				default:
+					break;
+			}
+
+			line.finish(message, truncated);
+			return line.write(fd);
+		}
+
+
+	}
+
+
+}
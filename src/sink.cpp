@@ -0,0 +1,79 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/sink.hpp>
+#include <logsys/config.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+
+namespace logsys{
+
+
+	sink_list sinks(){
+		return config()->sinks;
+	}
+
+	void add_sink(std::shared_ptr< sink > s){
+		modify_config([&s](configuration& c){
+				auto list = c.sinks.sinks();
+				list.push_back(std::move(s));
+				c.sinks = sink_list(std::move(list));
+			});
+	}
+
+	void remove_sink(sink const* s){
+		modify_config([s](configuration& c){
+				auto list = c.sinks.sinks();
+				list.erase(std::remove_if(list.begin(), list.end(),
+					[s](auto const& v){ return v.get() == s; }), list.end());
+				c.sinks = sink_list(std::move(list));
+			});
+	}
+
+	void clear_sinks(){
+		modify_config([](configuration& c){ c.sinks = sink_list(); });
+	}
+
+
+	void ostream_sink::write(record_info const&, line_ptr const& line)noexcept{
+		std::lock_guard< std::mutex > lock(mutex_);
+		os_ << *line;
+	}
+
+
+	file_sink::file_sink(std::string const& filename)
+		: detail::file_holder{std::ofstream(filename, std::ios::app)}
+		, ostream_sink(file)
+	{
+		if(!file.is_open()){
+			throw std::runtime_error("can not open log file: " + filename);
+		}
+	}
+
+
+	void ring_sink::write(record_info const&, line_ptr const& line)noexcept try{
+		std::lock_guard< std::mutex > lock(mutex_);
+		if(capacity_ == 0) return;
+		if(lines_.size() == capacity_){
+			lines_.pop_front();
+		}
+		lines_.push_back(line);
+	}catch(...){
+		// deque allocation failed, the line is lost
+	}
+
+	std::vector< line_ptr > ring_sink::lines()const{
+		std::lock_guard< std::mutex > lock(mutex_);
+		return std::vector< line_ptr >(lines_.begin(), lines_.end());
+	}
+
+
+}
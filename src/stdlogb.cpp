@@ -8,6 +8,7 @@
 //-----------------------------------------------------------------------------
 #include <logsys/stdlogb_factory_object.hpp>
 #include <logsys/stdlogb.hpp>
+#include <logsys/config.hpp>
 
 #include <cassert>
 
@@ -16,6 +17,11 @@ namespace logsys{
 
 
 	std::unique_ptr< stdlog_base > stdlogb::factory()noexcept try{
+		auto const factory = detail::config_factory();
+		if(factory != nullptr){
+			return factory();
+		}
+
 		assert(stdlogb_factory_object != nullptr);
 		return stdlogb_factory_object();
 	}catch(std::exception const& e){
@@ -0,0 +1,99 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/stdlog.hpp>
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+
+namespace{
+
+
+	template < typename T >
+	void expect_same(T value, int precision = 6){
+		std::ostringstream expected;
+		expected.precision(precision);
+		expected << value;
+
+		std::ostringstream os;
+		os.precision(precision);
+		logsys::detail::write_number(os, value);
+
+		EXPECT_EQ(os.str(), expected.str());
+	}
+
+
+	TEST(append, integers){
+		expect_same(0);
+		expect_same(-1);
+		expect_same(std::numeric_limits< int >::min());
+		expect_same(std::numeric_limits< unsigned >::max());
+		expect_same(std::numeric_limits< long long >::min());
+		expect_same(std::numeric_limits< unsigned long long >::max());
+		expect_same(static_cast< short >(-300));
+	}
+
+	TEST(append, floats){
+		for(double v: {0.0, -0.0, 1.0, 0.1, 1.5, -2.25, 1e-7, 123456.0,
+			1234567.0, 3.14159265358979, 1e300, -1e-300,
+			std::numeric_limits< double >::infinity(),
+			std::numeric_limits< double >::denorm_min()}
+		){
+			for(int precision: {0, 1, 3, 6, 10, 17}){
+				expect_same(v, precision);
+				expect_same(static_cast< float >(v), precision);
+				expect_same(static_cast< long double >(v), precision);
+			}
+		}
+	}
+
+	TEST(append, not_plain){
+		std::ostringstream os;
+		os << std::hex << std::showbase;
+		logsys::detail::write_number(os, 255);
+		os << ' ' << std::dec << std::setw(5) << std::setfill('*');
+		logsys::detail::write_number(os, 42);
+		os << ' ' << std::fixed << std::setprecision(2);
+		logsys::detail::write_number(os, 1.0);
+		EXPECT_EQ(os.str(), "0xff ***42 1.00");
+	}
+
+	TEST(append, stdlog){
+		logsys::stdlog log;
+		log << 'a' << ' ' << -5 << " " << 2.5 << " " << std::hex << 255u;
+		auto const line = log.make_log_line();
+		EXPECT_NE(line.find(") 9732-5 2.5 ff"), std::string::npos);
+	}
+
+	TEST(append, duration_column){
+		using namespace std::chrono;
+		auto const start = system_clock::time_point(seconds(1));
+		for(auto d: {nanoseconds(0), nanoseconds(52000),
+			nanoseconds(1234567), nanoseconds(98765432109)}
+		){
+			auto const info = logsys::record_info{7, start, start + d,
+				logsys::body_state::exists, false, logsys::level::info};
+
+			std::ostringstream expected;
+			expected << " ( " << std::setprecision(3) << std::setw(12)
+				<< duration< double, std::milli >(d).count() << "ms ) ";
+
+			auto const line =
+				logsys::stdlog::make_log_line(info, "x", nullptr, nullptr);
+			EXPECT_EQ(line.substr(0, 7), "000007 ");
+			EXPECT_NE(line.find(expected.str()), std::string::npos) << line;
+		}
+	}
+
+
+}
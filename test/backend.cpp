@@ -0,0 +1,694 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/backend.hpp>
+#include <logsys/deferred_log.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+namespace{
+
+
+	using logsys::detail::closure;
+
+
+	/// \brief Redirect std::clog into a string
+	struct clog_capture{
+		clog_capture(): old(std::clog.rdbuf(os.rdbuf())) {}
+
+		~clog_capture(){
+			std::clog.rdbuf(old);
+		}
+
+		std::string str()const{
+			return os.str();
+		}
+
+		std::ostringstream os;
+		std::streambuf* old;
+	};
+
+
+	/// \brief Sink policy that counts the written lines
+	struct line_sink{
+		static void write(logsys::record_info const&, std::string const&){
+			++lines;
+		}
+
+		static inline std::size_t lines = 0;
+	};
+
+
+	/// \brief Runs the backend with a budget of two records
+	///
+	/// The backend thread is held by a blocking record, so the queue is
+	/// filled deterministically.
+	struct budget_fixture{
+		budget_fixture(
+			logsys::overflow_policy policy,
+			std::chrono::milliseconds timeout = std::chrono::milliseconds(10)
+		):
+			before(logsys::backend_statistics())
+		{
+			logsys::start_backend(logsys::backend_options{
+				2 * sizeof(closure), policy, timeout});
+
+			closure blocker([this]{
+					started = true;
+					while(!released) std::this_thread::yield();
+				});
+			EXPECT_TRUE(logsys::detail::backend_post(blocker));
+			while(!started) std::this_thread::yield();
+		}
+
+		~budget_fixture(){
+			release();
+			logsys::stop_backend();
+			logsys::start_backend();
+			logsys::stop_backend();
+		}
+
+		/// \brief Post a record that appends id to executed
+		bool post(int id){
+			closure record([this, id]{ executed.push_back(id); });
+			return logsys::detail::backend_post(record);
+		}
+
+		/// \brief Post a record with time stamp id seconds
+		bool post_at(int id){
+			closure record([this, id]{ executed.push_back(id); });
+			auto const time = std::chrono::system_clock::time_point(
+				std::chrono::seconds(id));
+			return logsys::detail::backend_post(record, time);
+		}
+
+		void release(){
+			released = true;
+		}
+
+		/// \brief Counters since construction
+		logsys::backend_counters counters()const{
+			auto c = logsys::backend_statistics();
+			c.posted -= before.posted;
+			c.executed -= before.executed;
+			c.blocked -= before.blocked;
+			c.block_timeouts -= before.block_timeouts;
+			c.dropped_newest -= before.dropped_newest;
+			c.overwritten -= before.overwritten;
+			c.synchronous -= before.synchronous;
+			c.parks -= before.parks;
+			c.wakeups -= before.wakeups;
+			return c;
+		}
+
+		logsys::backend_counters const before;
+		std::atomic< bool > started{false};
+		std::atomic< bool > released{false};
+		std::vector< int > executed;
+	};
+
+
+	TEST(backend, footprint){
+		closure small([]{});
+		EXPECT_EQ(small.footprint(), sizeof(closure));
+
+		struct big{
+			char data[closure::buffer_size + 1];
+			void operator()(){}
+		};
+		closure large(big{});
+		EXPECT_EQ(large.footprint(), sizeof(closure) + sizeof(big));
+
+		// heap memory of strings is counted, the in place buffer is not
+		std::string const text(1000, 'x');
+		closure line(logsys::detail::deferred_line< line_sink >{{}, text});
+		EXPECT_GE(line.footprint(), sizeof(closure) + text.size());
+		closure short_line(logsys::detail::deferred_line< line_sink >{{}, "x"});
+		EXPECT_EQ(short_line.footprint(), sizeof(closure));
+	}
+
+	TEST(backend, budget_counts_strings){
+		clog_capture capture;
+		budget_fixture f(logsys::overflow_policy::drop_newest);
+		line_sink::lines = 0;
+
+		// fits the budget by size of the closure, but not with its line
+		EXPECT_TRUE(f.post(1));
+		logsys::deferred_sink< line_sink >::write(
+			logsys::record_info{}, std::string(1000, 'x'));
+
+		f.release();
+		logsys::flush_backend();
+		EXPECT_EQ(line_sink::lines, 0);
+		EXPECT_EQ(f.executed, (std::vector< int >{1}));
+		EXPECT_EQ(f.counters().dropped_newest, 1);
+	}
+
+	TEST(backend, merge_by_time){
+		budget_fixture f(logsys::overflow_policy::block);
+		logsys::start_backend();
+
+		// every thread posts into its own ring, the rings are reclaimed
+		// after the threads ended
+		std::thread([&f]{ f.post_at(2); f.post_at(4); f.post_at(5); }).join();
+		std::thread([&f]{ f.post_at(1); f.post_at(3); }).join();
+		std::thread([&f]{ f.post_at(6); }).join();
+
+		f.release();
+		logsys::flush_backend();
+		EXPECT_EQ(f.executed, (std::vector< int >{1, 2, 3, 4, 5, 6}));
+	}
+
+	TEST(backend, flush_waits_for_execution){
+		logsys::start_backend();
+
+		// popped, but still executing when flush_backend() is called
+		std::atomic< bool > started{false};
+		std::atomic< bool > finished{false};
+		closure record([&started, &finished]{
+				started = true;
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				finished = true;
+			});
+		ASSERT_TRUE(logsys::detail::backend_post(record));
+		while(!started) std::this_thread::yield();
+
+		logsys::flush_backend();
+		EXPECT_TRUE(finished);
+		logsys::stop_backend();
+	}
+
+	TEST(backend, wakeup_only_when_parked){
+		budget_fixture f(logsys::overflow_policy::block);
+		logsys::start_backend();
+
+		// backend thread is busy, no wakeups
+		for(int i = 0; i < 10; ++i) EXPECT_TRUE(f.post(i));
+		EXPECT_EQ(f.counters().wakeups, 0);
+
+		f.release();
+		logsys::flush_backend();
+		while(f.counters().parks == 0) std::this_thread::yield();
+
+		// backend thread sleeps, one wakeup
+		EXPECT_TRUE(f.post(10));
+		logsys::flush_backend();
+		EXPECT_EQ(f.counters().wakeups, 1);
+		EXPECT_EQ(f.executed.size(), 11);
+	}
+
+	/// \brief true if fd is readable
+	bool readable(int fd){
+		pollfd p{fd, POLLIN, 0};
+		return ::poll(&p, 1, 0) == 1 && (p.revents & POLLIN) != 0;
+	}
+
+	TEST(backend, poll_mode){
+		clog_capture capture;
+		logsys::start_polling(logsys::backend_options(), 3);
+		ASSERT_TRUE(logsys::backend_running());
+		auto const fd = logsys::backend_event_fd();
+		ASSERT_GE(fd, 0);
+
+		auto const log = [](int i){
+				logsys::log([i](logsys::stdlogq& log){ log << "queued " << i; });
+			};
+
+		log(1);
+		log(2);
+		EXPECT_FALSE(readable(fd));
+		EXPECT_EQ(capture.str(), "");
+		log(3);
+		EXPECT_TRUE(readable(fd));
+
+		EXPECT_EQ(logsys::flush_some(2), 2);
+		EXPECT_FALSE(readable(fd));
+		EXPECT_NE(capture.str().find("queued 2"), std::string::npos);
+		EXPECT_EQ(capture.str().find("queued 3"), std::string::npos);
+
+		EXPECT_EQ(logsys::flush_some(10), 1);
+		EXPECT_NE(capture.str().find("queued 3"), std::string::npos);
+		EXPECT_EQ(logsys::flush_some(10), 0);
+
+		// the rest is executed by stop_backend()
+		log(4);
+		logsys::stop_backend();
+		EXPECT_FALSE(logsys::backend_running());
+		EXPECT_NE(capture.str().find("queued 4"), std::string::npos);
+		EXPECT_EQ(logsys::flush_some(10), 0);
+	}
+
+	TEST(backend, poll_mode_counts_executed_records){
+		logsys::start_polling(logsys::backend_options(), 1);
+
+		// the ring of the ended thread is reclaimed by the same drain
+		std::thread([]{
+				closure record([]{});
+				EXPECT_TRUE(logsys::detail::backend_post(record));
+			}).join();
+		EXPECT_EQ(logsys::flush_some(10), 1);
+		EXPECT_EQ(logsys::flush_some(10), 0);
+		logsys::stop_backend();
+	}
+
+	TEST(backend, poll_mode_concurrent_flush){
+		logsys::start_polling(logsys::backend_options(), 2);
+		auto const fd = logsys::backend_event_fd();
+		ASSERT_GE(fd, 0);
+
+		// records are executed while their producer is still in post()
+		std::atomic< bool > done{false};
+		std::thread consumer([&done]{
+				while(!done) logsys::flush_some(1);
+			});
+		for(int i = 0; i < 10000; ++i){
+			closure record([]{});
+			ASSERT_TRUE(logsys::detail::backend_post(record));
+		}
+		done = true;
+		consumer.join();
+		logsys::flush_some(std::numeric_limits< std::size_t >::max());
+
+		// the count of queued records is exact again
+		EXPECT_FALSE(readable(fd));
+		closure first([]{});
+		ASSERT_TRUE(logsys::detail::backend_post(first));
+		EXPECT_FALSE(readable(fd));
+		closure second([]{});
+		ASSERT_TRUE(logsys::detail::backend_post(second));
+		EXPECT_TRUE(readable(fd));
+		logsys::stop_backend();
+	}
+
+	TEST(backend, reclaim_under_churn){
+		logsys::start_polling(logsys::backend_options(), 1000);
+		auto const at = [](int seconds){
+				return std::chrono::system_clock::time_point(
+					std::chrono::seconds(seconds));
+			};
+
+		// the ring of this thread holds a record all the time
+		closure pending([]{});
+		ASSERT_TRUE(logsys::detail::backend_post(pending, at(1000000)));
+		auto const before = logsys::backend_statistics().ring_bytes;
+
+		for(int i = 0; i < 256; ++i){
+			std::thread([&at, i]{
+					closure record([]{});
+					logsys::detail::backend_post(record, at(i));
+				}).join();
+		}
+		EXPECT_GT(logsys::backend_statistics().ring_bytes, before);
+
+		// the rings of the ended threads are reclaimed while busy
+		EXPECT_EQ(logsys::flush_some(256), 256);
+		EXPECT_LE(logsys::backend_statistics().ring_bytes, before);
+
+		logsys::stop_backend();
+	}
+
+	TEST(backend, parse_cpu_list){
+		using logsys::detail::parse_cpu_list;
+		EXPECT_EQ(parse_cpu_list("0-3,8,10-11\n"),
+			(std::vector< int >{0, 1, 2, 3, 8, 10, 11}));
+		EXPECT_EQ(parse_cpu_list(""), std::vector< int >());
+		EXPECT_EQ(parse_cpu_list("3-1"), std::vector< int >());
+		EXPECT_EQ(parse_cpu_list("a"), std::vector< int >());
+	}
+
+	TEST(backend, simulated_numa_nodes){
+		auto const nodes = logsys::detail::numa_nodes(2);
+		ASSERT_EQ(nodes.size(), 2);
+
+		std::vector< int > cpus;
+		for(auto const& node: nodes){
+			cpus.insert(cpus.end(), node.begin(), node.end());
+		}
+		EXPECT_EQ(cpus.size(), std::thread::hardware_concurrency());
+		EXPECT_LT(logsys::detail::current_node(nodes), 2);
+	}
+
+	TEST(backend, sysfs_numa_nodes){
+		auto const dir = std::string("logsys_numa_test");
+		auto const write = [&dir](std::string const& name, char const* text){
+				std::ofstream os(dir + "/" + name);
+				os << text;
+			};
+		::mkdir(dir.c_str(), 0700);
+		::mkdir((dir + "/node0").c_str(), 0700);
+		::mkdir((dir + "/node2").c_str(), 0700);
+		::mkdir((dir + "/node3").c_str(), 0700);
+		write("online", "0,2-3\n");
+		write("node0/cpulist", "0-1\n");
+		write("node2/cpulist", "2,3\n");
+		write("node3/cpulist", "\n");
+
+		EXPECT_EQ(logsys::detail::sysfs_numa_nodes(dir),
+			(std::vector< std::vector< int > >{{0, 1}, {2, 3}, {}}));
+
+		for(auto const name: {"node0/cpulist", "node2/cpulist",
+			"node3/cpulist", "online", "node0", "node2", "node3", ""}
+		) std::remove((dir + "/" + name).c_str());
+
+		EXPECT_TRUE(logsys::detail::sysfs_numa_nodes(dir).empty());
+	}
+
+	/// \brief CPUs of the calling thread
+	std::vector< int > thread_cpus(){
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		sched_getaffinity(0, sizeof(set), &set);
+		std::vector< int > result;
+		for(int i = 0; i < CPU_SETSIZE; ++i){
+			if(CPU_ISSET(i, &set)) result.push_back(i);
+		}
+		return result;
+	}
+
+	TEST(backend, affinity){
+		auto const cpus = thread_cpus();
+		ASSERT_FALSE(cpus.empty());
+
+		logsys::backend_options options;
+		options.cpu_affinity = {cpus.front()};
+		logsys::start_backend(options);
+
+		std::vector< int > backend_cpus;
+		closure record([&backend_cpus]{ backend_cpus = thread_cpus(); });
+		EXPECT_TRUE(logsys::detail::backend_post(record));
+		logsys::flush_backend();
+		logsys::stop_backend();
+
+		EXPECT_EQ(backend_cpus, std::vector< int >{cpus.front()});
+	}
+
+	TEST(backend, numa_shards){
+		logsys::backend_options options;
+		options.numa_shards = true;
+		options.simulated_numa_nodes = 2;
+		logsys::start_backend(options);
+
+		// a new thread registers its ring on its current node
+		auto const nodes = logsys::detail::numa_nodes(2);
+		std::size_t node = 0;
+		std::vector< int > backend_cpus;
+		std::thread([&]{
+				node = logsys::detail::current_node(nodes);
+				closure record([&backend_cpus]{
+						backend_cpus = thread_cpus();
+					});
+				EXPECT_TRUE(logsys::detail::backend_post(record));
+			}).join();
+
+		logsys::flush_backend();
+		logsys::stop_backend();
+
+		if(!nodes[node].empty()){
+			EXPECT_EQ(backend_cpus, nodes[node]);
+		}
+	}
+
+	/// \brief Count of resident pages of buffer
+	std::size_t resident_pages(logsys::detail::page_buffer const& buffer){
+		auto const page = static_cast< std::size_t >(::sysconf(_SC_PAGESIZE));
+		std::vector< unsigned char > pages((buffer.size() + page - 1) / page);
+		::mincore(buffer.data(), buffer.size(), pages.data());
+		std::size_t result = 0;
+		for(auto const p: pages) result += p & 1;
+		return result;
+	}
+
+	TEST(backend, page_buffer){
+		using logsys::detail::page_buffer;
+		auto const page = static_cast< std::size_t >(::sysconf(_SC_PAGESIZE));
+
+		page_buffer lazy(10 * page + 1, logsys::huge_pages::none, false, false);
+		EXPECT_EQ(lazy.size(), 11 * page);
+		EXPECT_FALSE(lazy.huge());
+		EXPECT_EQ(resident_pages(lazy), 0);
+
+		page_buffer eager(10 * page, logsys::huge_pages::none, true, true);
+		EXPECT_EQ(resident_pages(eager), 10);
+
+		page_buffer thp(1, logsys::huge_pages::transparent, true, false);
+		EXPECT_EQ(thp.size(), page_buffer::huge_page_size);
+		EXPECT_EQ(reinterpret_cast< std::uintptr_t >(thp.data())
+			% page_buffer::huge_page_size, 0);
+
+		// every page is faulted, also if the system uses normal pages
+		EXPECT_EQ(resident_pages(thp), page_buffer::huge_page_size / page);
+
+		// falls back to normal pages if the pool is empty
+		page_buffer tlb(1, logsys::huge_pages::hugetlb, false, false);
+		EXPECT_NE(tlb.data(), nullptr);
+
+		auto moved = std::move(eager);
+		EXPECT_EQ(eager.data(), nullptr);
+		EXPECT_EQ(moved.size(), 10 * page);
+	}
+
+	TEST(backend, prepared_ring){
+		logsys::backend_options options;
+		options.ring_capacity = 16;
+		options.ring_pages = logsys::huge_pages::transparent;
+		options.prefault = true;
+		options.lock_memory = true;
+		logsys::start_backend(options);
+
+		bool executed = false;
+		std::thread([&executed]{
+				logsys::prepare_backend_thread();
+				EXPECT_GE(logsys::backend_statistics().ring_bytes,
+					logsys::detail::page_buffer::huge_page_size);
+
+				closure record([&executed]{ executed = true; });
+				EXPECT_TRUE(logsys::detail::backend_post(record));
+			}).join();
+
+		logsys::flush_backend();
+		logsys::stop_backend();
+		EXPECT_TRUE(executed);
+	}
+
+	/// \brief Post a record that writes c to fd, execute it if not posted
+	void post_char(int fd, char c){
+		closure record([fd, c]{
+				[[maybe_unused]] auto const r = ::write(fd, &c, 1);
+			});
+		if(!logsys::detail::backend_post(record)) record();
+	}
+
+	TEST(backend, fork){
+		int fds[2];
+		ASSERT_EQ(::pipe(fds), 0);
+		logsys::start_backend();
+
+		// a producer that only exists in the parent
+		std::atomic< bool > forked{false};
+		std::size_t produced = 0;
+		std::thread producer([&]{
+				while(!forked || produced < 100){
+					post_char(fds[1], 'p');
+					++produced;
+					std::this_thread::yield();
+				}
+			});
+
+		for(int i = 0; i < 5; ++i) post_char(fds[1], 'm');
+		auto const id = logsys::per_thread_id::next();
+
+		auto const pid = ::fork();
+		if(pid == 0){
+			int status = 0;
+			if(!logsys::backend_running()) status |= 1;
+			constexpr auto bits = logsys::per_thread_id::counter_bits;
+			if(logsys::per_thread_id::next() >> bits == id >> bits){
+				status |= 2;
+			}
+			post_char(fds[1], 'c');
+			logsys::flush_backend();
+			logsys::stop_backend();
+			::_exit(status);
+		}
+		forked = true;
+
+		ASSERT_GT(pid, 0);
+		int status = 0;
+		ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+		EXPECT_TRUE(WIFEXITED(status));
+		EXPECT_EQ(WEXITSTATUS(status), 0);
+
+		EXPECT_TRUE(logsys::backend_running());
+		post_char(fds[1], 'q');
+		producer.join();
+		logsys::stop_backend();
+
+		::close(fds[1]);
+		std::string text;
+		char buffer[256];
+		ssize_t count;
+		while((count = ::read(fds[0], buffer, sizeof(buffer))) > 0){
+			text.append(buffer, static_cast< std::size_t >(count));
+		}
+		::close(fds[0]);
+
+		// records queued before fork() are output once
+		EXPECT_EQ(std::count(text.begin(), text.end(), 'm'), 5);
+		EXPECT_EQ(std::count(text.begin(), text.end(), 'c'), 1);
+		EXPECT_EQ(std::count(text.begin(), text.end(), 'q'), 1);
+		EXPECT_EQ(static_cast< std::size_t >(
+			std::count(text.begin(), text.end(), 'p')), produced);
+	}
+
+	/// \brief Post a record that calls fork(), the child exits at once
+	///
+	/// \return false if the record was not posted
+	bool post_fork(int& status){
+		closure record([&status]{
+				auto const pid = ::fork();
+				if(pid == 0) ::_exit(7);
+				if(pid < 0 || ::waitpid(pid, &status, 0) != pid) status = -1;
+			});
+		return logsys::detail::backend_post(record);
+	}
+
+	TEST(backend, fork_in_record){
+		logsys::start_backend();
+
+		int status = -1;
+		ASSERT_TRUE(post_fork(status));
+		logsys::flush_backend();
+		EXPECT_TRUE(WIFEXITED(status));
+		EXPECT_EQ(WEXITSTATUS(status), 7);
+
+		// the backend thread continues in the parent
+		EXPECT_TRUE(logsys::backend_running());
+		std::atomic< bool > executed{false};
+		closure record([&executed]{ executed = true; });
+		ASSERT_TRUE(logsys::detail::backend_post(record));
+		logsys::flush_backend();
+		EXPECT_TRUE(executed);
+		logsys::stop_backend();
+	}
+
+	TEST(backend, fork_in_record_polling){
+		logsys::start_polling(logsys::backend_options(), 1);
+
+		int status = -1;
+		ASSERT_TRUE(post_fork(status));
+		EXPECT_EQ(logsys::flush_some(10), 1);
+		EXPECT_TRUE(WIFEXITED(status));
+		EXPECT_EQ(WEXITSTATUS(status), 7);
+
+		std::atomic< bool > executed{false};
+		closure record([&executed]{ executed = true; });
+		ASSERT_TRUE(logsys::detail::backend_post(record));
+		EXPECT_EQ(logsys::flush_some(10), 1);
+		EXPECT_TRUE(executed);
+		logsys::stop_backend();
+	}
+
+	TEST(backend, drop_newest){
+		clog_capture capture;
+		{
+			budget_fixture f(logsys::overflow_policy::drop_newest);
+			EXPECT_TRUE(f.post(1));
+			EXPECT_TRUE(f.post(2));
+			EXPECT_TRUE(f.post(3));
+			EXPECT_EQ(f.counters().queued_bytes, 2 * sizeof(closure));
+
+			f.release();
+			logsys::flush_backend();
+			EXPECT_EQ(f.executed, (std::vector< int >{1, 2}));
+
+			auto const c = f.counters();
+			EXPECT_EQ(c.dropped_newest, 1);
+			EXPECT_EQ(c.posted, 3);
+			EXPECT_EQ(c.queued_bytes, 0);
+			EXPECT_GE(c.peak_bytes, 2 * sizeof(closure));
+		}
+		EXPECT_NE(capture.str().find("logsys backend lost 1 record by "),
+			std::string::npos) << capture.str();
+	}
+
+	TEST(backend, overwrite_oldest){
+		clog_capture capture;
+		budget_fixture f(logsys::overflow_policy::overwrite_oldest);
+		EXPECT_TRUE(f.post(1));
+		EXPECT_TRUE(f.post(2));
+		EXPECT_TRUE(f.post(3));
+
+		f.release();
+		logsys::flush_backend();
+		EXPECT_EQ(f.executed, (std::vector< int >{2, 3}));
+		EXPECT_EQ(f.counters().overwritten, 1);
+	}
+
+	TEST(backend, synchronous){
+		budget_fixture f(logsys::overflow_policy::synchronous);
+		EXPECT_TRUE(f.post(1));
+		EXPECT_TRUE(f.post(2));
+		EXPECT_FALSE(f.post(3));
+
+		f.release();
+		logsys::flush_backend();
+		EXPECT_EQ(f.executed, (std::vector< int >{1, 2}));
+		EXPECT_EQ(f.counters().synchronous, 1);
+	}
+
+	TEST(backend, block){
+		clog_capture capture;
+		budget_fixture f(logsys::overflow_policy::block);
+		EXPECT_TRUE(f.post(1));
+		EXPECT_TRUE(f.post(2));
+
+		// timeout, record is dropped
+		EXPECT_TRUE(f.post(3));
+		EXPECT_EQ(f.counters().blocked, 1);
+		EXPECT_EQ(f.counters().block_timeouts, 1);
+
+		// space is freed while waiting
+		logsys::start_backend(logsys::backend_options{
+			2 * sizeof(closure), logsys::overflow_policy::block,
+			std::chrono::seconds(10)});
+		std::thread releaser([&f]{
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+				f.release();
+			});
+		EXPECT_TRUE(f.post(4));
+		releaser.join();
+
+		logsys::flush_backend();
+		EXPECT_EQ(f.executed, (std::vector< int >{1, 2, 4}));
+		EXPECT_EQ(f.counters().blocked, 2);
+		EXPECT_EQ(f.counters().block_timeouts, 1);
+	}
+
+
+}
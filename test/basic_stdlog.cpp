@@ -0,0 +1,262 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/stdlog.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <memory_resource>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace logsys{
+
+
+	// stdlog can be forward declared
+	class stdlog;
+
+
+}
+
+
+namespace{
+
+
+	/// \brief Clock that advances by one millisecond per call
+	struct step_clock{
+		static std::chrono::system_clock::time_point now()noexcept{
+			static std::chrono::system_clock::time_point time;
+			return time += std::chrono::milliseconds(1);
+		}
+	};
+
+	/// \brief Counts from 100
+	struct test_id{
+		static std::size_t next()noexcept{
+			static std::size_t id = 100;
+			return id++;
+		}
+	};
+
+	/// \brief Collects the lines
+	struct vector_sink{
+		static void write(logsys::record_info const&, std::string const& line){
+			lines().push_back(line);
+		}
+
+		static std::vector< std::string >& lines(){
+			static std::vector< std::string > result;
+			return result;
+		}
+	};
+
+	using test_stdlog = logsys::basic_stdlog<
+		logsys::inline_buffer< 16 >, step_clock, test_id, vector_sink >;
+
+
+	TEST(basic_stdlog, policies){
+		vector_sink::lines().clear();
+
+		logsys::log([](test_stdlog& log){
+				log << "value " << 42 << ' ' << 1.5 << true;
+			}, []{});
+
+		EXPECT_THROW(logsys::log([](test_stdlog& log){
+				log.format("{} is a long message", "this");
+			}, []{ throw std::runtime_error("error"); }), std::runtime_error);
+
+		auto const& lines = vector_sink::lines();
+		ASSERT_EQ(lines.size(), 2);
+		EXPECT_EQ(lines[0].substr(0, 7), "000100 ");
+		EXPECT_NE(lines[0].find("(            1ms ) value 42321.5tru\n"),
+			std::string::npos) << lines[0];
+		EXPECT_EQ(lines[1].substr(0, 7), "000101 ");
+		EXPECT_NE(lines[1].find("ms ) this is a long m (BODY FAILED: "),
+			std::string::npos) << lines[1];
+	}
+
+	/// \brief Uses the protected members of stdlog
+	struct derived_stdlog: logsys::stdlog{
+		std::string text()const{
+			return os_.str();
+		}
+
+		static std::string describe(std::exception_ptr error){
+			std::ostringstream os;
+			print_exception(os, error);
+			return os.str();
+		}
+
+		static std::size_t id()noexcept{
+			return unique_id();
+		}
+	};
+
+	TEST(basic_stdlog, stdlog_compatibility){
+		derived_stdlog log;
+		log << "value " << 42;
+		EXPECT_EQ(log.text(), "value 42");
+
+		EXPECT_NE(derived_stdlog::describe(std::make_exception_ptr(
+			std::runtime_error("error"))).find("] error"), std::string::npos);
+		auto const first = derived_stdlog::id();
+		EXPECT_LT(first, derived_stdlog::id());
+
+		logsys::stdlog moved(std::move(log));
+		moved << " moved";
+		EXPECT_NE(moved.make_log_line().find("value 42 moved"),
+			std::string::npos);
+
+		static_assert(std::is_move_assignable_v< logsys::stdlog >);
+		logsys::stdlog assigned;
+		assigned = std::move(moved);
+		assigned << " assigned";
+		EXPECT_NE(assigned.make_log_line().find("value 42 moved assigned"),
+			std::string::npos);
+	}
+
+	TEST(basic_stdlog, make_log_line_from_view){
+		auto const text = std::string("[a\nb]");
+		auto const line = logsys::stdlog::make_log_line(logsys::record_info{},
+			std::string_view(text).substr(1, 3), nullptr, nullptr);
+		EXPECT_NE(line.find("no content     ) a\\nb\n"), std::string::npos);
+	}
+
+	TEST(basic_stdlog, inline_buffer){
+		logsys::inline_buffer< 8 > buffer;
+		buffer.insert("abc");
+		buffer.insert(12);
+		EXPECT_FALSE(buffer.truncated());
+		buffer.insert(std::string("defgh"));
+		EXPECT_TRUE(buffer.truncated());
+		EXPECT_EQ(buffer.str(), "abc12def");
+	}
+
+	TEST(basic_stdlog, arena_buffer){
+		auto& arena = logsys::detail::message_arena::local();
+		{
+			logsys::arena_buffer outer;
+			outer.insert("outer ");
+			{
+				logsys::arena_buffer inner;
+				inner.insert("inner ");
+				inner.insert(1);
+				EXPECT_EQ(inner.str(), "inner 1");
+			}
+			outer.insert(2.5);
+			outer.insert(true);
+			EXPECT_EQ(outer.str(), "outer 2.5true");
+			EXPECT_EQ(outer.size(), 13);
+		}
+
+		// a chain of segments over several chunks
+		std::string const part(1000, 'x');
+		std::string expect;
+		{
+			logsys::arena_buffer buffer;
+			for(std::size_t i = 0; i < 40; ++i){
+				buffer.insert(part);
+				buffer.insert(i);
+				expect += part + std::to_string(i);
+			}
+			EXPECT_EQ(buffer.str(), expect);
+		}
+
+		// memory is reused
+		auto const chunks = arena.chunk_count();
+		EXPECT_GE(chunks, 3);
+		{
+			logsys::arena_buffer buffer;
+			for(std::size_t i = 0; i < 40; ++i) buffer.insert(part);
+		}
+		EXPECT_EQ(arena.chunk_count(), chunks);
+
+		// nested messages of a living outer message reuse the memory
+		{
+			logsys::arena_buffer outer;
+			outer.insert("outer");
+			for(std::size_t i = 0; i < 1000; ++i){
+				{
+					logsys::arena_buffer inner;
+					inner.insert(part);
+				}
+				outer.insert(i % 10);
+			}
+			EXPECT_EQ(outer.size(), 1005);
+			EXPECT_EQ(arena.chunk_count(), chunks);
+		}
+	}
+
+	/// \brief Counts the allocated bytes
+	struct counting_resource: std::pmr::memory_resource{
+		std::size_t bytes = 0;
+
+		void* do_allocate(std::size_t size, std::size_t align)override{
+			bytes += size;
+			return std::pmr::new_delete_resource()->allocate(size, align);
+		}
+
+		void do_deallocate(void* p, std::size_t size, std::size_t align)
+		override{
+			std::pmr::new_delete_resource()->deallocate(p, size, align);
+		}
+
+		bool do_is_equal(std::pmr::memory_resource const& other)
+		const noexcept override{
+			return this == &other;
+		}
+	};
+
+	TEST(basic_stdlog, pmr_buffer){
+		EXPECT_EQ(logsys::log_memory_resource(),
+			std::pmr::get_default_resource());
+
+		counting_resource resource;
+		{
+			logsys::memory_resource_scope scope(&resource);
+			EXPECT_EQ(logsys::log_memory_resource(), &resource);
+
+			std::thread([]{
+					EXPECT_EQ(logsys::log_memory_resource(),
+						std::pmr::get_default_resource());
+				}).join();
+
+			logsys::pmr_buffer buffer;
+			EXPECT_EQ(buffer.resource(), &resource);
+			buffer.insert(std::string(100, 'x'));
+			buffer.insert(42);
+			EXPECT_EQ(buffer.view(), std::string(100, 'x') + "42");
+		}
+		EXPECT_GT(resource.bytes, 100);
+		EXPECT_EQ(logsys::log_memory_resource(),
+			std::pmr::get_default_resource());
+	}
+
+	TEST(basic_stdlog, per_thread_id){
+		auto const a = logsys::per_thread_id::next();
+		auto const b = logsys::per_thread_id::next();
+		EXPECT_EQ(b, a + 1);
+
+		std::size_t c = 0;
+		std::thread([&c]{ c = logsys::per_thread_id::next(); }).join();
+		EXPECT_NE(c >> logsys::per_thread_id::counter_bits,
+			a >> logsys::per_thread_id::counter_bits);
+	}
+
+	TEST(basic_stdlog, coarse_system_clock){
+		using namespace std::chrono;
+		auto const diff = system_clock::now() - logsys::coarse_system_clock::now();
+		EXPECT_LT(duration_cast< milliseconds >(diff).count(), 100);
+	}
+
+
+}
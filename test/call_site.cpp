@@ -0,0 +1,292 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/call_site.hpp>
+#include <logsys/log.hpp>
+#include <logsys/stdlog.hpp>
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <limits>
+#include <thread>
+
+
+namespace{
+
+
+	struct test_log{
+		logsys::level level = logsys::level::info;
+		void exec()noexcept{}
+		void set_body_exception(std::exception_ptr, bool)noexcept{}
+		void set_log_exception(std::exception_ptr)noexcept{}
+		void set_level(logsys::level l)noexcept{ level = l; }
+	};
+
+	struct warning_log: test_log{
+		warning_log()noexcept{ level = logsys::level::warning; }
+	};
+
+
+	struct text_log{
+		static std::vector< std::string > lines;
+
+		std::string text;
+
+		void exec()noexcept{ lines.push_back(text); }
+		void set_body_exception(std::exception_ptr, bool)noexcept{}
+		void set_log_exception(std::exception_ptr)noexcept{}
+
+		friend text_log& operator<<(text_log& log, char const* value){
+			log.text += value;
+			return log;
+		}
+
+		friend text_log& operator<<(text_log& log, std::uint64_t value){
+			log.text += std::to_string(value);
+			return log;
+		}
+	};
+
+	std::vector< std::string > text_log::lines;
+
+
+	logsys::call_site* find_site(unsigned line){
+		for(auto site: logsys::call_sites()){
+			if(
+				site->location().line == line &&
+				std::strstr(site->location().file, "call_site.cpp") != nullptr
+			){
+				return site;
+			}
+		}
+		return nullptr;
+	}
+
+
+	TEST(call_site, location){
+		auto const line = __LINE__; logsys::log([](test_log&){});
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		EXPECT_EQ(site->calls(), 1);
+		EXPECT_NE(std::strstr(site->location().function, "TestBody"), nullptr);
+	}
+
+	TEST(call_site, one_descriptor_per_lambda){
+		auto const log_f = [](test_log&){};
+		auto const line = __LINE__; logsys::log(log_f);
+		logsys::log(log_f);
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		EXPECT_EQ(site->calls(), 2);
+		EXPECT_EQ(find_site(line + 1), nullptr);
+	}
+
+	TEST(call_site, statistics){
+		unsigned line = 0;
+		for(std::size_t i = 0; i < 3; ++i){
+			line = __LINE__; logsys::exception_catching_log([](test_log&){},
+				[i]{ if(i == 1) throw std::runtime_error("error"); });
+		}
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		EXPECT_EQ(site->calls(), 3);
+		EXPECT_EQ(site->failures(), 1);
+		EXPECT_GT(site->total_time().count(), 0);
+	}
+
+	TEST(call_site, failure_counted_once){
+		unsigned line = 0;
+		line = __LINE__; logsys::exception_catching_log([](test_log&){
+				throw std::runtime_error("log");
+			}, []{ throw std::runtime_error("body"); });
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		EXPECT_EQ(site->calls(), 1);
+		EXPECT_EQ(site->failures(), 1);
+	}
+
+	TEST(call_site, counters_per_thread){
+		unsigned line = 0;
+		auto const log = [&line]{
+				line = __LINE__; logsys::log([](test_log&){});
+			};
+
+		// ended threads pass their counters to the next ones
+		for(std::size_t round = 0; round < 3; ++round){
+			std::vector< std::thread > threads;
+			for(std::size_t i = 0; i < 4; ++i){
+				threads.emplace_back([&log]{
+						for(std::size_t j = 0; j < 100; ++j) log();
+					});
+			}
+			for(auto& thread: threads) thread.join();
+		}
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		EXPECT_EQ(site->calls(), 1200);
+	}
+
+	TEST(call_site, body_time_of_log){
+		unsigned line = 0;
+		line = __LINE__; logsys::log([](logsys::stdlog&){}, []{
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			});
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		EXPECT_GE(site->total_time(), std::chrono::milliseconds(2));
+	}
+
+	TEST(call_site, disable){
+		bool log_called = false;
+		bool body_called = false;
+		auto const log_f = [&log_called](test_log&){ log_called = true; };
+		auto const line = __LINE__; logsys::log(log_f, []{});
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		EXPECT_TRUE(log_called);
+		site->enable(false);
+
+		log_called = false;
+		auto const result = logsys::log(log_f, [&body_called]{
+				body_called = true;
+				return 5;
+			});
+
+		EXPECT_EQ(result, 5);
+		EXPECT_TRUE(body_called);
+		EXPECT_FALSE(log_called);
+		EXPECT_EQ(site->calls(), 1);
+
+		EXPECT_FALSE(logsys::exception_catching_log(log_f,
+			[]{ throw std::runtime_error("error"); }));
+		EXPECT_FALSE(log_called);
+	}
+
+	TEST(call_site, level){
+		logsys::level level = logsys::level::info;
+		auto const log_f = [&level](test_log& log){ level = log.level; };
+		auto const line = __LINE__; logsys::log(log_f);
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		EXPECT_EQ(level, logsys::level::info);
+
+		site->set_level(logsys::level::debug);
+		logsys::log(log_f);
+		EXPECT_EQ(level, logsys::level::debug);
+	}
+
+	TEST(call_site, level_unset){
+		logsys::level level = logsys::level::trace;
+		auto const log_f = [&level](warning_log& log){ level = log.level; };
+		auto const line = __LINE__; logsys::log(log_f);
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		EXPECT_FALSE(site->level());
+		EXPECT_EQ(level, logsys::level::warning);
+
+		site->set_level(logsys::level::info);
+		logsys::log(log_f);
+		EXPECT_EQ(level, logsys::level::info);
+
+		site->restore_defaults();
+		EXPECT_FALSE(site->level());
+		logsys::log(log_f);
+		EXPECT_EQ(level, logsys::level::warning);
+	}
+
+	TEST(call_site, sampling){
+		std::size_t log_calls = 0;
+		std::size_t body_calls = 0;
+		auto const log_f = [&log_calls](test_log&){ ++log_calls; };
+		auto const line = __LINE__; logsys::log(log_f, []{});
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		site->set_sampling(4);
+
+		log_calls = 0;
+		for(std::size_t i = 0; i < 16; ++i){
+			logsys::log(log_f, [&body_calls]{ ++body_calls; });
+		}
+
+		EXPECT_EQ(body_calls, 16);
+		EXPECT_EQ(log_calls, 4);
+		EXPECT_EQ(site->suppressed(), 12);
+
+		// every thread has its own sampling counter
+		std::thread([&log_f]{ logsys::log(log_f, []{}); }).join();
+		EXPECT_EQ(log_calls, 5);
+	}
+
+	TEST(call_site, rate_limit){
+		text_log::lines.clear();
+		auto const log_f = [](text_log& log){ log << "message"; };
+		auto const line = __LINE__; logsys::log(log_f);
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		site->set_rate_limit(1, 2);
+
+		text_log::lines.clear();
+		for(std::size_t i = 0; i < 10; ++i){
+			logsys::log(log_f);
+		}
+
+		// burst of 2
+		EXPECT_EQ(text_log::lines.size(), 2);
+		EXPECT_EQ(site->suppressed(), 8);
+
+		site->set_rate_limit(0);
+		logsys::log(log_f);
+
+		ASSERT_EQ(text_log::lines.size(), 4);
+		EXPECT_EQ(text_log::lines[2], "suppressed 8 messages");
+		EXPECT_EQ(text_log::lines[3], "message");
+	}
+
+	TEST(call_site, rate_limit_saturation){
+		auto const log_f = [](text_log& log){ log << "message"; };
+		auto const line = __LINE__; logsys::log(log_f);
+
+		auto site = find_site(line);
+		ASSERT_NE(site, nullptr);
+		auto const max_burst = std::numeric_limits< std::uint32_t >::max();
+
+		// interval times burst exceeds the range, the whole burst passes
+		site->set_rate_limit(0.1, max_burst);
+		text_log::lines.clear();
+		for(std::size_t i = 0; i < 10; ++i) logsys::log(log_f);
+		EXPECT_EQ(text_log::lines.size(), 10);
+
+		// the interval exceeds the range, only the first call passes
+		site->set_rate_limit(1e-300, max_burst);
+		text_log::lines.clear();
+		for(std::size_t i = 0; i < 10; ++i) logsys::log(log_f);
+		EXPECT_EQ(text_log::lines.size(), 1);
+
+		// a new limit starts with a full bucket
+		site->set_rate_limit(1, 2);
+		text_log::lines.clear();
+		for(std::size_t i = 0; i < 10; ++i) logsys::log(log_f);
+		ASSERT_EQ(text_log::lines.size(), 3);
+		EXPECT_EQ(text_log::lines[0], "suppressed 9 messages");
+
+		site->set_rate_limit(0);
+	}
+
+}
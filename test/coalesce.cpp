@@ -0,0 +1,129 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/coalesce.hpp>
+#include <logsys/config.hpp>
+#include <logsys/stdlogb.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+
+
+namespace{
+
+
+	logsys::record_info make_info(
+		std::size_t id,
+		std::chrono::milliseconds duration
+	){
+		auto const start = std::chrono::system_clock::time_point(
+			std::chrono::seconds(id));
+		return logsys::record_info{id, start, start + duration,
+			logsys::body_state::exists, false, logsys::level::info};
+	}
+
+
+	TEST(coalesce, coalescer){
+		using std::chrono::milliseconds;
+		logsys::coalescer c;
+
+		auto r = c.add(make_info(0, milliseconds(5)), "a");
+		EXPECT_FALSE(r.duplicate);
+		EXPECT_FALSE(r.summary);
+
+		EXPECT_TRUE(c.add(make_info(1, milliseconds(3)), "a").duplicate);
+		EXPECT_TRUE(c.add(make_info(2, milliseconds(7)), "a").duplicate);
+
+		auto info = make_info(3, milliseconds(5));
+		info.level = logsys::level::error;
+		r = c.add(info, "a");
+		EXPECT_FALSE(r.duplicate);
+		ASSERT_TRUE(r.summary);
+		EXPECT_EQ(r.summary->count, 2);
+		EXPECT_EQ(r.summary->last.id, 2);
+		EXPECT_EQ(r.summary->first_start, make_info(1, milliseconds(0)).start);
+		EXPECT_EQ(r.summary->min_duration, milliseconds(3));
+		EXPECT_EQ(r.summary->max_duration, milliseconds(7));
+
+		auto const line = r.summary->make_log_line();
+		EXPECT_EQ(line.find("000002 "), 0) << line;
+		EXPECT_NE(line.find(" ( no content     ) previous message repeated 2 "
+			"times until "), std::string::npos) << line;
+		EXPECT_NE(line.find(" (body duration min 3ms, max 7ms)\n"),
+			std::string::npos) << line;
+
+		r = c.add(make_info(4, milliseconds(5)), "b");
+		EXPECT_FALSE(r.duplicate);
+		EXPECT_FALSE(r.summary);
+		EXPECT_FALSE(c.flush());
+	}
+
+	TEST(coalesce, exceptions){
+		using std::chrono::milliseconds;
+		logsys::coalescer c;
+
+		auto info = make_info(0, milliseconds(5));
+		info.body = logsys::body_state::catched_exception;
+		auto const timeout = std::make_exception_ptr(
+			std::runtime_error("timeout"));
+		auto const refused = std::make_exception_ptr(
+			std::runtime_error("refused"));
+		auto const range = std::make_exception_ptr(
+			std::out_of_range("timeout"));
+
+		EXPECT_FALSE(c.add(info, "connect", timeout).duplicate);
+		EXPECT_TRUE(c.add(info, "connect", timeout).duplicate);
+
+		// equal text, but a different failure
+		auto r = c.add(info, "connect", refused);
+		EXPECT_FALSE(r.duplicate);
+		ASSERT_TRUE(r.summary);
+		EXPECT_EQ(r.summary->count, 1);
+		EXPECT_FALSE(c.add(info, "connect", range).duplicate);
+
+		// an equal exception thrown again is a duplicate
+		EXPECT_TRUE(c.add(info, "connect",
+			std::make_exception_ptr(std::out_of_range("timeout"))).duplicate);
+
+		// the log exception is compared too
+		info.body = logsys::body_state::exists;
+		info.log_exception = true;
+		EXPECT_FALSE(c.add(info, "connect", nullptr, timeout).duplicate);
+		EXPECT_FALSE(c.add(info, "connect", nullptr, refused).duplicate);
+		EXPECT_TRUE(c.add(info, "connect", nullptr, refused).duplicate);
+	}
+
+	TEST(coalesce, stdlogb){
+		auto const old = *logsys::config();
+		auto ring = std::make_shared< logsys::ring_sink >(10);
+		logsys::modify_config([&ring](logsys::configuration& c){
+				c.sinks = logsys::sink_list({ring});
+				c.coalesce = true;
+			});
+
+		for(std::size_t i = 0; i < 5; ++i){
+			logsys::log([](logsys::stdlogb& log){ log << "retry"; });
+		}
+		logsys::log([](logsys::stdlogb& log){ log << "done"; });
+		logsys::log([](logsys::stdlogb& log){ log << "done"; });
+		logsys::flush_coalesced();
+
+		logsys::set_config(old);
+
+		auto lines = ring->lines();
+		ASSERT_EQ(lines.size(), 4);
+		EXPECT_NE(lines[0]->find("retry"), std::string::npos);
+		EXPECT_NE(lines[1]->find("repeated 4 times"), std::string::npos);
+		EXPECT_NE(lines[2]->find("done"), std::string::npos);
+		EXPECT_NE(lines[3]->find("repeated 1 times"), std::string::npos);
+	}
+
+
+}
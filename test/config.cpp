@@ -0,0 +1,175 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/config.hpp>
+#include <logsys/stdlogb.hpp>
+#include <logsys/stdlogd.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+
+namespace{
+
+
+	/// \brief Restore the configuration at scope exit
+	struct config_guard{
+		config_guard(): old_(*logsys::config()) {}
+
+		~config_guard(){
+			logsys::set_config(old_);
+		}
+
+		logsys::configuration old_;
+	};
+
+
+	/// \brief Set a flag on destruction
+	struct destruction_sink: logsys::sink{
+		destruction_sink(std::atomic< bool >& destroyed)
+			: destroyed_(destroyed) {}
+
+		~destruction_sink()noexcept override{
+			destroyed_ = true;
+		}
+
+		void write(
+			logsys::record_info const&,
+			logsys::line_ptr const&
+		)noexcept override {}
+
+		std::atomic< bool >& destroyed_;
+	};
+
+
+	std::atomic< std::size_t > factory_calls{0};
+
+	std::unique_ptr< logsys::stdlog_base > counting_factory()noexcept{
+		++factory_calls;
+		return std::make_unique< logsys::stdlogd >();
+	}
+
+
+	TEST(config, level_threshold){
+		config_guard guard;
+		auto ring = std::make_shared< logsys::ring_sink >(4);
+		logsys::modify_config([&ring](logsys::configuration& c){
+				c.sinks = logsys::sink_list({ring});
+				c.threshold = logsys::level::warning;
+			});
+
+		logsys::log([](logsys::stdlogb& log){ log << "info"; });
+		logsys::log([](logsys::stdlogb& log){
+				log << logsys::level::error << "error";
+			});
+
+		auto lines = ring->lines();
+		ASSERT_EQ(lines.size(), 1);
+		EXPECT_NE(lines[0]->find("error"), std::string::npos);
+	}
+
+	TEST(config, duration_threshold){
+		config_guard guard;
+		auto counter = std::make_shared< logsys::counter_sink >();
+		logsys::modify_config([&counter](logsys::configuration& c){
+				c.sinks = logsys::sink_list({counter});
+				c.duration_threshold = std::chrono::hours(1);
+			});
+
+		logsys::log([](logsys::stdlogb&){}, []{});
+		logsys::log([](logsys::stdlogb&){});
+		logsys::exception_catching_log([](logsys::stdlogb&){},
+			[]{ throw std::runtime_error("error"); });
+
+		EXPECT_EQ(counter->records(), 2);
+		EXPECT_EQ(counter->failures(), 1);
+	}
+
+	TEST(config, factory){
+		config_guard guard;
+		logsys::modify_config([](logsys::configuration& c){
+				c.sinks = logsys::sink_list();
+				c.factory = &counting_factory;
+			});
+
+		auto const before = factory_calls.load();
+		logsys::log([](logsys::stdlogb&){});
+		EXPECT_EQ(factory_calls.load(), before + 1);
+	}
+
+	TEST(config, swap_while_logging){
+		config_guard guard;
+		auto counter = std::make_shared< logsys::counter_sink >();
+		logsys::modify_config([&counter](logsys::configuration& c){
+				c.sinks = logsys::sink_list({counter});
+			});
+
+		std::atomic< bool > stop{false};
+		std::thread logger([&stop]{
+				while(!stop){
+					logsys::log([](logsys::stdlogb& log){ log << "x"; });
+				}
+			});
+
+		for(std::size_t i = 0; i < 100; ++i){
+			logsys::modify_config([i](logsys::configuration& c){
+					c.threshold = i % 2 == 0
+						? logsys::level::trace : logsys::level::error;
+				});
+		}
+
+		stop = true;
+		logger.join();
+
+		EXPECT_EQ(counter->failures(), 0);
+	}
+
+	TEST(config, removed_sink_is_destroyed){
+		config_guard guard;
+		std::atomic< bool > destroyed{false};
+		auto s = std::make_shared< destruction_sink >(destroyed);
+		auto const raw = s.get();
+		logsys::add_sink(std::move(s));
+
+		logsys::log([](logsys::stdlogb& log){ log << "x"; });
+		EXPECT_FALSE(destroyed);
+
+		logsys::remove_sink(raw);
+		EXPECT_TRUE(destroyed);
+	}
+
+	TEST(config, reader_keeps_config_alive){
+		config_guard guard;
+		std::atomic< bool > destroyed{false};
+		auto s = std::make_shared< destruction_sink >(destroyed);
+		auto const raw = s.get();
+		logsys::add_sink(std::move(s));
+
+		std::atomic< bool > reading{false};
+		std::atomic< bool > release{false};
+		std::thread reader([&]{
+				auto const c = logsys::config();
+				reading = true;
+				while(!release) std::this_thread::yield();
+				EXPECT_FALSE(destroyed);
+				EXPECT_EQ(c->sinks.sinks().back().get(), raw);
+			});
+		while(!reading) std::this_thread::yield();
+
+		// destroyed by the reader when it is done
+		logsys::remove_sink(raw);
+		EXPECT_FALSE(destroyed);
+		release = true;
+		reader.join();
+		EXPECT_TRUE(destroyed);
+	}
+
+
+}
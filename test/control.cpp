@@ -0,0 +1,255 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/control.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+
+namespace{
+
+
+	using logsys::detail::glob_match;
+
+
+	struct test_log{
+		void exec()noexcept{}
+		void set_body_exception(std::exception_ptr, bool)noexcept{}
+		void set_log_exception(std::exception_ptr)noexcept{}
+	};
+
+
+	void control_func_a(){
+		logsys::log([](test_log&){});
+	}
+
+	void control_func_b(){
+		logsys::log([](test_log&){});
+	}
+
+	void control_func_late(bool& called){
+		logsys::log([&called](test_log&){ called = true; });
+	}
+
+	void control_func_file(bool& called){
+		logsys::log([&called](test_log&){ called = true; });
+	}
+
+	void control_func_reload(){
+		logsys::log([](test_log&){});
+	}
+
+	void control_func_api(){
+		logsys::log([](test_log&){});
+	}
+
+
+	logsys::call_site* find_site(char const* function){
+		for(auto site: logsys::call_sites()){
+			if(std::string_view(site->location().function) == function){
+				return site;
+			}
+		}
+		return nullptr;
+	}
+
+
+	TEST(control, glob_match){
+		EXPECT_TRUE(glob_match("", ""));
+		EXPECT_TRUE(glob_match("*", ""));
+		EXPECT_TRUE(glob_match("*", "abc"));
+		EXPECT_TRUE(glob_match("a?c", "abc"));
+		EXPECT_TRUE(glob_match("*.cpp", "src/net/socket.cpp"));
+		EXPECT_TRUE(glob_match("src/*/s*t.cpp", "src/net/socket.cpp"));
+		EXPECT_TRUE(glob_match("a*b*c", "aXXbYYbc"));
+		EXPECT_FALSE(glob_match("", "a"));
+		EXPECT_FALSE(glob_match("a?c", "ac"));
+		EXPECT_FALSE(glob_match("*.hpp", "socket.cpp"));
+		EXPECT_FALSE(glob_match("a*b*c", "aXXbYYb"));
+	}
+
+	TEST(control, invalid_commands){
+		EXPECT_THROW(logsys::control(""), std::invalid_argument);
+		EXPECT_THROW(logsys::control("file"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("file x.cpp"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("line x -p"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("foo -p"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("level=loud"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("sample=x"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("ratelimit=-1"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("ratelimit=1/"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("sample=-1"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("sample=+1"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("sample=4294967296"),
+			std::invalid_argument);
+		EXPECT_THROW(logsys::control("line 99999999999 -p"),
+			std::invalid_argument);
+		EXPECT_THROW(logsys::control("line 1--2 -p"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("ratelimit=1/-1"),
+			std::invalid_argument);
+		EXPECT_THROW(logsys::control("ratelimit=1/4294967296"),
+			std::invalid_argument);
+		EXPECT_THROW(logsys::control("ratelimit=nan"), std::invalid_argument);
+		EXPECT_THROW(logsys::control("ratelimit=inf"), std::invalid_argument);
+		EXPECT_NO_THROW(logsys::control(
+			"func no_such_function sample=4294967295"));
+		EXPECT_NO_THROW(logsys::control(
+			"func no_such_function ratelimit=1e-300/4294967295"));
+	}
+
+	TEST(control, function_glob){
+		control_func_a();
+		control_func_b();
+
+		auto a = find_site("control_func_a");
+		auto b = find_site("control_func_b");
+		ASSERT_NE(a, nullptr);
+		ASSERT_NE(b, nullptr);
+
+		EXPECT_EQ(logsys::control(
+			"file control.cpp func control_func_? -p level=debug"), 2);
+		EXPECT_FALSE(a->enabled());
+		EXPECT_FALSE(b->enabled());
+		EXPECT_EQ(a->level(), logsys::level::debug);
+
+		EXPECT_EQ(logsys::control("func control_func_b +p"), 1);
+		EXPECT_FALSE(a->enabled());
+		EXPECT_TRUE(b->enabled());
+
+		EXPECT_EQ(logsys::control("func control_func_a sample=3"), 1);
+		EXPECT_EQ(a->sampling(), 3);
+
+		EXPECT_EQ(logsys::control(
+			"func control_func_a level=info +p sample=0 ratelimit=0"), 1);
+	}
+
+	TEST(control, later_registered_site){
+		logsys::control("func control_func_late -p");
+
+		bool called = false;
+		control_func_late(called);
+		EXPECT_FALSE(called);
+
+		logsys::control("func control_func_late +p");
+		control_func_late(called);
+		EXPECT_TRUE(called);
+	}
+
+	TEST(control, watch_file){
+		auto const filename = std::string("logsys_control_test.txt");
+		{
+			std::ofstream os(filename);
+			os << "# test\n\nfunc control_func_file -p\n";
+		}
+
+		logsys::watch_control_file(filename);
+
+		bool called = false;
+		control_func_file(called);
+		EXPECT_FALSE(called);
+
+		{
+			std::ofstream os(filename);
+			os << "func control_func_file +p\n";
+		}
+
+		auto site = find_site("control_func_file");
+		ASSERT_NE(site, nullptr);
+		for(std::size_t i = 0; i < 200 && !site->enabled(); ++i){
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		control_func_file(called);
+		EXPECT_TRUE(called);
+
+		logsys::unwatch_control_file();
+		std::remove(filename.c_str());
+	}
+
+	TEST(control, reload_reverts_removed_commands){
+		auto const filename = std::string("logsys_control_reload.txt");
+		{
+			std::ofstream os(filename);
+			os << "func control_func_reload -p sample=4\n"
+				"func control_func_reload level=debug ratelimit=10\n";
+		}
+
+		control_func_reload();
+		auto site = find_site("control_func_reload");
+		ASSERT_NE(site, nullptr);
+
+		logsys::watch_control_file(filename);
+		EXPECT_FALSE(site->enabled());
+		EXPECT_EQ(site->sampling(), 4);
+		EXPECT_EQ(site->level(), logsys::level::debug);
+
+		// control() takes precedence over the file, the later command wins
+		logsys::control("func control_func_reload level=warning");
+		logsys::control("func control_func_reload level=error");
+
+		{
+			std::ofstream os(filename);
+			os << "# nothing\n";
+		}
+
+		for(std::size_t i = 0; i < 200 && !site->enabled(); ++i){
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		EXPECT_TRUE(site->enabled());
+		EXPECT_EQ(site->sampling(), 0);
+		EXPECT_EQ(site->level(), logsys::level::error);
+
+		logsys::unwatch_control_file();
+		std::remove(filename.c_str());
+		logsys::control("func control_func_reload level=info");
+	}
+
+	TEST(control, reload_keeps_api_state){
+		auto const filename = std::string("logsys_control_api.txt");
+		{
+			std::ofstream os(filename);
+			os << "func control_func_file sample=2\n";
+		}
+
+		bool called = false;
+		control_func_file(called);
+		control_func_api();
+		auto site = find_site("control_func_api");
+		ASSERT_NE(site, nullptr);
+		site->set_level(logsys::level::warning);
+
+		logsys::watch_control_file(filename);
+		{
+			std::ofstream os(filename);
+			os << "func control_func_file sample=3\n";
+		}
+
+		auto file_site = find_site("control_func_file");
+		ASSERT_NE(file_site, nullptr);
+		for(std::size_t i = 0; i < 200 && file_site->sampling() != 3; ++i){
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		EXPECT_EQ(file_site->sampling(), 3);
+		EXPECT_EQ(site->level(), logsys::level::warning);
+
+		logsys::unwatch_control_file();
+		EXPECT_EQ(file_site->sampling(), 0);
+		EXPECT_EQ(site->level(), logsys::level::warning);
+		site->restore_defaults();
+		std::remove(filename.c_str());
+	}
+
+
+}
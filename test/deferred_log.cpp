@@ -0,0 +1,158 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/deferred_log.hpp>
+#include <logsys/stdlogb.hpp>
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+
+namespace{
+
+
+	using logsys::detail::closure;
+	using logsys::detail::is_deferrable_v;
+	using logsys::detail::nobody_t;
+
+
+	/// \brief Redirect std::clog into a string
+	struct clog_capture{
+		clog_capture(): old(std::clog.rdbuf(os.rdbuf())) {}
+
+		~clog_capture(){
+			std::clog.rdbuf(old);
+		}
+
+		std::string str()const{
+			return os.str();
+		}
+
+		std::ostringstream os;
+		std::streambuf* old;
+	};
+
+
+	TEST(deferred_log, closure){
+		int calls = 0;
+		auto increment = [&calls]{ ++calls; };
+		EXPECT_TRUE(closure::is_inplace_v< decltype(increment) >);
+		closure small(increment);
+
+		struct big{
+			char data[closure::buffer_size + 1];
+			int* calls;
+			void operator()(){ ++*calls; }
+		};
+		EXPECT_FALSE(closure::is_inplace_v< big >);
+		closure large(big{{}, &calls});
+
+		auto moved_small = std::move(small);
+		auto moved_large = std::move(large);
+		EXPECT_FALSE(small);
+		EXPECT_FALSE(large);
+
+		moved_small();
+		moved_large();
+		EXPECT_EQ(calls, 2);
+
+		auto counter = std::make_shared< int >(0);
+		{
+			closure c([counter]{});
+			EXPECT_EQ(counter.use_count(), 2);
+		}
+		EXPECT_EQ(counter.use_count(), 1);
+	}
+
+	TEST(deferred_log, deferrable){
+		auto by_value = [i = 5](logsys::stdlog& log){ log << i; };
+		auto dynamic = [](logsys::stdlogb& log){ log << 5; };
+		auto with_value =
+			[](logsys::stdlog&, logsys::optional< int > const&){};
+		auto with_ref =
+			[](logsys::stdlog&, logsys::optional< int& > const&){};
+
+		EXPECT_TRUE((is_deferrable_v< decltype(by_value), nobody_t >));
+		EXPECT_FALSE((is_deferrable_v< decltype(dynamic), nobody_t >));
+		EXPECT_TRUE((is_deferrable_v< decltype(with_value), int >));
+		EXPECT_FALSE((is_deferrable_v< decltype(with_ref), int& >));
+	}
+
+	TEST(deferred_log, inline_without_backend){
+		ASSERT_FALSE(logsys::backend_running());
+		clog_capture capture;
+
+		auto const id = std::this_thread::get_id();
+		auto thread = std::thread::id();
+		// executed inline, so the reference can not dangle
+		logsys::deferred_log(logsys::by_value,
+			[id, &thread](logsys::stdlog& log){
+				thread = std::this_thread::get_id();
+				log << "inline";
+			});
+
+		EXPECT_EQ(thread, id);
+		EXPECT_NE(capture.str().find("inline"), std::string::npos);
+	}
+
+	TEST(deferred_log, not_deferrable_without_tag){
+		logsys::start_backend();
+
+		// stdlogb is not deferrable, so no by_value is needed
+		auto const id = std::this_thread::get_id();
+		auto thread = std::thread::id();
+		logsys::deferred_log([&thread](logsys::stdlogb&){
+				thread = std::this_thread::get_id();
+			});
+		EXPECT_EQ(thread, id);
+
+		logsys::stop_backend();
+	}
+
+	TEST(deferred_log, backend){
+		clog_capture capture;
+		logsys::start_backend();
+		ASSERT_TRUE(logsys::backend_running());
+
+		auto const id = std::this_thread::get_id();
+		auto thread = std::make_shared< std::thread::id >();
+		logsys::deferred_log(logsys::by_value,
+			[thread, text = std::string("deferred")](logsys::stdlog& log){
+				*thread = std::this_thread::get_id();
+				log << text;
+			});
+
+		int value = logsys::deferred_log(logsys::by_value,
+			[](logsys::stdlog& log, logsys::optional< int > const& v){
+				log << "value " << *v;
+			}, []{ return 42; });
+		EXPECT_EQ(value, 42);
+
+		EXPECT_THROW(logsys::deferred_log(logsys::by_value,
+			[](logsys::stdlog& log){ log << "failing"; },
+			[]{ throw std::runtime_error("body error"); }),
+			std::runtime_error);
+
+		logsys::flush_backend();
+		logsys::stop_backend();
+		EXPECT_FALSE(logsys::backend_running());
+
+		EXPECT_NE(*thread, id);
+		auto const output = capture.str();
+		EXPECT_NE(output.find("deferred"), std::string::npos);
+		EXPECT_NE(output.find("value 42"), std::string::npos);
+		EXPECT_NE(output.find("failing (BODY FAILED: "), std::string::npos);
+	}
+
+
+}
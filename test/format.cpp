@@ -0,0 +1,109 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/stdlog.hpp>
+#include <logsys/stdlogb.hpp>
+#include <logsys/config.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+
+namespace{
+
+
+	using logsys::detail::count_placeholders;
+
+	static_assert(count_placeholders("") == 0);
+	static_assert(count_placeholders("a {} b {}") == 2);
+	static_assert(count_placeholders("{{}} {}") == 1);
+
+
+	/// \brief Records the texts passed to append()
+	struct append_counter: logsys::stdlog_base{
+		void append(std::string_view text)override{
+			texts().emplace_back(text);
+		}
+
+		std::ostream& os()noexcept override{
+			return os_;
+		}
+
+		static std::vector< std::string >& texts(){
+			static std::vector< std::string > result;
+			return result;
+		}
+
+		std::ostringstream os_;
+	};
+
+	std::unique_ptr< logsys::stdlog_base > make_append_counter()noexcept{
+		return std::make_unique< append_counter >();
+	}
+
+
+	/// \brief Message part of a log line
+	std::string text_of(std::string const& line){
+		auto const pos = line.find(" ) ");
+		return line.substr(pos + 3, line.size() - pos - 4);
+	}
+
+
+	TEST(format, stdlog){
+		logsys::stdlog log;
+		log.format("a {} b {} c {}", 1, "two", 3.5);
+		EXPECT_EQ(text_of(log.make_log_line()), "a 1 b two c 3.5");
+	}
+
+	TEST(format, escapes){
+		logsys::stdlog log;
+		log.format("{{{}}} }}{{", 'x').format("{}", true);
+		EXPECT_EQ(text_of(log.make_log_line()), "{120} }{true");
+	}
+
+	TEST(format, same_as_operator){
+		logsys::stdlog log1;
+		logsys::stdlog log2;
+		auto const text = std::string("text");
+		log1 << -7 << " " << text << " " << 0.125 << " " << false;
+		log2.format("{} {} {} {}", -7, text, 0.125, false);
+		EXPECT_EQ(text_of(log1.make_log_line()), text_of(log2.make_log_line()));
+	}
+
+	TEST(format, invalid){
+		EXPECT_THROW(count_placeholders("{"), std::invalid_argument);
+		EXPECT_THROW(count_placeholders("}"), std::invalid_argument);
+		EXPECT_THROW(count_placeholders("{:x}"), std::invalid_argument);
+
+#ifndef __cpp_consteval
+		logsys::stdlog log;
+		EXPECT_THROW(log.format("{} {}", 1), std::invalid_argument);
+#endif
+	}
+
+	TEST(format, stdlogb_one_virtual_call){
+		auto const old = *logsys::config();
+		logsys::modify_config([](logsys::configuration& c){
+				c.factory = &make_append_counter;
+			});
+		append_counter::texts().clear();
+
+		logsys::log([](logsys::stdlogb& log){
+				log.format("x={} y={} z={}", 1, 2, "three");
+			});
+
+		logsys::set_config(old);
+
+		ASSERT_EQ(append_counter::texts().size(), 1);
+		EXPECT_EQ(append_counter::texts()[0], "x=1 y=2 z=three");
+	}
+
+
+}
@@ -8,6 +8,7 @@
 //-----------------------------------------------------------------------------
 #include <logsys/stdlog.hpp>
 #include <logsys/stdlogb.hpp>
+#include <logsys/stdlogt.hpp>
 #include <logsys/log.hpp>
 
 #include "gtest/gtest.h"
@@ -272,6 +273,7 @@ namespace{
 
 	template struct test_log_object< logsys::stdlog >;
 	template struct test_log_object< logsys::stdlogb >;
+	template struct test_log_object< logsys::stdlogt< struct log_tag > >;
 
 
 
@@ -0,0 +1,118 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/retain.hpp>
+#include <logsys/config.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+
+
+namespace{
+
+
+	struct ring_guard{
+		ring_guard()
+			: old(*logsys::config())
+			, ring(std::make_shared< logsys::ring_sink >(10))
+		{
+			logsys::modify_config([this](logsys::configuration& c){
+					c.sinks = logsys::sink_list({ring});
+				});
+		}
+
+		~ring_guard(){
+			logsys::set_config(old);
+		}
+
+		bool contains(std::size_t i, char const* text)const{
+			auto lines = ring->lines();
+			return i < lines.size() &&
+				lines[i]->find(text) != std::string::npos;
+		}
+
+		logsys::configuration old;
+		std::shared_ptr< logsys::ring_sink > ring;
+	};
+
+
+	void detail_line(char const* text){
+		logsys::log([text](logsys::stdlogb& log){ log << text; });
+	}
+
+
+	TEST(retain, success_discards){
+		ring_guard guard;
+
+		logsys::log([](logsys::stdlogr& log){ log << "scope"; }, []{
+				detail_line("detail 1");
+				detail_line("detail 2");
+			});
+
+		ASSERT_EQ(guard.ring->lines().size(), 1);
+		EXPECT_TRUE(guard.contains(0, "scope"));
+	}
+
+	TEST(retain, failure_outputs){
+		ring_guard guard;
+
+		EXPECT_THROW(
+			logsys::log([](logsys::stdlogr& log){ log << "scope"; }, []{
+					detail_line("detail 1");
+					detail_line("detail 2");
+					throw std::runtime_error("error");
+				}),
+			std::runtime_error);
+
+		ASSERT_EQ(guard.ring->lines().size(), 3);
+		EXPECT_TRUE(guard.contains(0, "detail 1"));
+		EXPECT_TRUE(guard.contains(1, "detail 2"));
+		EXPECT_TRUE(guard.contains(2, "BODY FAILED"));
+
+		// arena is empty again
+		detail_line("after");
+		ASSERT_EQ(guard.ring->lines().size(), 4);
+		EXPECT_TRUE(guard.contains(3, "after"));
+	}
+
+	TEST(retain, nested){
+		ring_guard guard;
+
+		// inner failure is handed over to the succeeding outer scope
+		logsys::log([](logsys::stdlogr& log){ log << "outer"; }, []{
+				detail_line("detail 1");
+				logsys::exception_catching_log(
+					[](logsys::stdlogr& log){ log << "inner"; }, []{
+						detail_line("detail 2");
+						throw std::runtime_error("error");
+					});
+			});
+
+		ASSERT_EQ(guard.ring->lines().size(), 1);
+		EXPECT_TRUE(guard.contains(0, "outer"));
+
+		// inner success is discarded, outer failure outputs the rest
+		logsys::exception_catching_log(
+			[](logsys::stdlogr& log){ log << "outer"; }, []{
+				detail_line("detail 3");
+				logsys::log([](logsys::stdlogr& log){ log << "inner"; }, []{
+						detail_line("detail 4");
+					});
+				throw std::runtime_error("error");
+			});
+
+		ASSERT_EQ(guard.ring->lines().size(), 4);
+		EXPECT_TRUE(guard.contains(1, "detail 3"));
+		EXPECT_TRUE(guard.contains(2, "inner"));
+		EXPECT_TRUE(guard.contains(3, "BODY EXCEPTION CATCHED"));
+	}
+
+
+}
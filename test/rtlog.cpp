@@ -0,0 +1,500 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/rtlog.hpp>
+#include <logsys/signal_log.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+// Interposition of the functions a real time thread must not call. The
+// definitions in the test executable replace the ones of the C library for
+// the executable and all shared libraries, including liblogsys and
+// libstdc++. Calls are counted while the calling thread is armed.
+
+namespace{
+
+
+	/// \brief true while the calling thread is in a real time section
+	thread_local bool armed = false;
+
+	std::atomic< std::size_t > allocations(0);
+	std::atomic< std::size_t > deallocations(0);
+	std::atomic< std::size_t > mutex_locks(0);
+	std::atomic< std::size_t > system_calls(0);
+
+	/// \brief The next definition of name, e.g. the one in the C library
+	template < typename F >
+	F next_definition(F& cache, char const* name)noexcept{
+		if(cache == nullptr){
+			cache = reinterpret_cast< F >(dlsym(RTLD_NEXT, name));
+		}
+		return cache;
+	}
+
+
+}
+
+
+extern "C"{
+
+
+	void* __libc_malloc(std::size_t size);
+	void* __libc_calloc(std::size_t count, std::size_t size);
+	void* __libc_realloc(void* ptr, std::size_t size);
+	void __libc_free(void* ptr);
+
+	void* malloc(std::size_t size)noexcept{
+		if(armed) ++allocations;
+		return __libc_malloc(size);
+	}
+
+	void* calloc(std::size_t count, std::size_t size)noexcept{
+		if(armed) ++allocations;
+		return __libc_calloc(count, size);
+	}
+
+	void* realloc(void* ptr, std::size_t size)noexcept{
+		if(armed) ++allocations;
+		return __libc_realloc(ptr, size);
+	}
+
+	void free(void* ptr)noexcept{
+		if(armed && ptr != nullptr) ++deallocations;
+		__libc_free(ptr);
+	}
+
+	int pthread_mutex_lock(pthread_mutex_t* mutex)noexcept{
+		static int(*next)(pthread_mutex_t*) = nullptr;
+		if(armed) ++mutex_locks;
+		return next_definition(next, "pthread_mutex_lock")(mutex);
+	}
+
+	ssize_t write(int fd, void const* data, std::size_t size){
+		static ssize_t(*next)(int, void const*, std::size_t) = nullptr;
+		if(armed) ++system_calls;
+		return next_definition(next, "write")(fd, data, size);
+	}
+
+	int sched_yield()noexcept{
+		static int(*next)() = nullptr;
+		if(armed) ++system_calls;
+		return next_definition(next, "sched_yield")();
+	}
+
+	/// Only the arguments the system call takes are read and forwarded.
+	/// Add the system calls of new callers to the switch.
+	long syscall(long number, ...)noexcept{
+		static long(*next)(long, ...) = nullptr;
+		if(armed) ++system_calls;
+
+		auto const call = next_definition(next, "syscall");
+		va_list args;
+		va_start(args, number);
+		long result;
+		switch(number){
+			case SYS_getpid:
+			case SYS_gettid:
+				result = call(number);
+			break;
+			case SYS_getrandom:{
+				auto const buffer = va_arg(args, void*);
+				auto const size = va_arg(args, std::size_t);
+				auto const flags = va_arg(args, unsigned);
+				result = call(number, buffer, size, flags);
+			}break;
+			case SYS_futex:{
+				auto const word = va_arg(args, void*);
+				auto const op = va_arg(args, int);
+				auto const value = va_arg(args, int);
+				auto const timeout = va_arg(args, void*);
+				auto const word2 = va_arg(args, void*);
+				auto const value3 = va_arg(args, int);
+				result = call(number, word, op, value, timeout, word2, value3);
+			}break;
+			default:
+				std::fprintf(stderr,
+					"test interposition: unknown syscall %ld\n", number);
+				std::abort();
+		}
+		va_end(args);
+		return result;
+	}
+
+
+}
+
+
+namespace{
+
+
+	/// \brief Counts the forbidden calls of the calling thread in its
+	///        lifetime
+	struct rt_section{
+		rt_section()noexcept:
+			allocations(::allocations.load()),
+			deallocations(::deallocations.load()),
+			mutex_locks(::mutex_locks.load()),
+			system_calls(::system_calls.load())
+		{
+			armed = true;
+		}
+
+		~rt_section(){
+			disarm();
+		}
+
+		void disarm()noexcept{
+			if(!armed) return;
+			armed = false;
+			allocations = ::allocations.load() - allocations;
+			deallocations = ::deallocations.load() - deallocations;
+			mutex_locks = ::mutex_locks.load() - mutex_locks;
+			system_calls = ::system_calls.load() - system_calls;
+		}
+
+		std::size_t allocations;
+		std::size_t deallocations;
+		std::size_t mutex_locks;
+		std::size_t system_calls;
+	};
+
+	/// \brief Keep the compiler from removing p
+	void escape(void const* p){
+		asm volatile("" : : "g"(p) : "memory");
+	}
+
+
+	struct clog_capture{
+		clog_capture(): old(std::clog.rdbuf(os.rdbuf())) {}
+
+		~clog_capture(){
+			std::clog.rdbuf(old);
+		}
+
+		std::string str()const{
+			return os.str();
+		}
+
+		std::ostringstream os;
+		std::streambuf* old;
+	};
+
+	std::size_t count_lines(std::string const& text){
+		return static_cast< std::size_t >(
+			std::count(text.begin(), text.end(), '\n'));
+	}
+
+
+	TEST(rtlog, harness_detects_calls){
+		std::mutex mutex;
+		rt_section section;
+
+		{
+			std::string text(100, 'x');
+			escape(text.data());
+		}
+		{
+			std::lock_guard< std::mutex > lock(mutex);
+		}
+		EXPECT_EQ(::write(-1, "", 0), -1);
+		::syscall(SYS_getpid);
+		sched_yield();
+		logsys::flush_rtlog();
+
+		section.disarm();
+		EXPECT_GE(section.allocations, 1);
+		EXPECT_GE(section.deallocations, 1);
+		EXPECT_GE(section.mutex_locks, 2);
+		EXPECT_GE(section.system_calls, 3);
+	}
+
+	TEST(rtlog, no_allocation_lock_or_system_call){
+		logsys::prepare_rt_thread();
+		logsys::flush_rtlog();
+		auto const before = logsys::rtlog_statistics();
+
+		auto const cycle = [](int i){
+				logsys::log([i](logsys::rtlog& log){
+						log << logsys::level::debug << "cycle " << i << " "
+							<< 0.5 << " " << true << std::string_view(" sv");
+					});
+				logsys::log([i](logsys::rtlog& log){
+						log.format("body {} of {}", i, "cycle");
+					}, []{});
+			};
+
+		// the first call registers the call sites
+		cycle(0);
+
+		rt_section section;
+		for(int i = 1; i < 100; ++i) cycle(i);
+		section.disarm();
+
+		EXPECT_EQ(section.allocations, 0);
+		EXPECT_EQ(section.deallocations, 0);
+		EXPECT_EQ(section.mutex_locks, 0);
+		EXPECT_EQ(section.system_calls, 0);
+
+		clog_capture capture;
+		EXPECT_EQ(logsys::flush_rtlog(), 200);
+		auto const text = capture.str();
+		EXPECT_EQ(count_lines(text), 200);
+		EXPECT_NE(text.find("( no content     ) cycle 99 0.5 true sv\n"),
+			std::string::npos) << text;
+		EXPECT_NE(text.find("ms ) body 99 of cycle\n"), std::string::npos);
+		EXPECT_LT(text.find("cycle 1 "), text.find("body 1 of"));
+
+		auto const after = logsys::rtlog_statistics();
+		EXPECT_EQ(after.posted - before.posted, 200);
+		EXPECT_EQ(after.written - before.written, 200);
+		EXPECT_EQ(after.dropped_full, before.dropped_full);
+		EXPECT_GT(after.ring_bytes, 0);
+	}
+
+#ifndef __cpp_consteval
+	TEST(rtlog, invalid_format_string){
+		logsys::prepare_rt_thread();
+		logsys::flush_rtlog();
+
+		auto const f = []{
+				logsys::log([](logsys::rtlog& log){
+						log.format("{} of {}", 1);
+					});
+			};
+		f();
+
+		rt_section section;
+		f();
+		section.disarm();
+
+		EXPECT_EQ(section.allocations, 0);
+		EXPECT_EQ(section.deallocations, 0);
+
+		clog_capture capture;
+		EXPECT_EQ(logsys::flush_rtlog(), 2);
+		EXPECT_NE(capture.str().find(
+			"( no content     ) INVALID FORMAT STRING: {} of {}\n"),
+			std::string::npos) << capture.str();
+	}
+#endif
+
+	TEST(rtlog, dropped_records){
+		auto const before = logsys::rtlog_statistics();
+
+		std::thread([]{
+				auto const f = []{
+						logsys::log([](logsys::rtlog& log){ log << "lost"; });
+					};
+				f();
+
+				rt_section section;
+				f();
+				section.disarm();
+				EXPECT_EQ(section.allocations, 0);
+			}).join();
+
+		auto const unprepared = logsys::rtlog_statistics();
+		EXPECT_EQ(unprepared.dropped_unprepared - before.dropped_unprepared, 2);
+
+		std::thread([]{
+				logsys::prepare_rt_thread(logsys::rtlog_options{1});
+				for(int i = 0; i < 100; ++i){
+					logsys::log([](logsys::rtlog& log){ log << "full"; });
+				}
+			}).join();
+
+		clog_capture capture;
+		auto const posted = logsys::flush_rtlog();
+		EXPECT_GE(posted, 1);
+		EXPECT_LT(posted, 100);
+		EXPECT_EQ(count_lines(capture.str()), posted);
+
+		auto const after = logsys::rtlog_statistics();
+		EXPECT_EQ(after.dropped_full - before.dropped_full, 100 - posted);
+	}
+
+	TEST(rtlog, truncated){
+		logsys::prepare_rt_thread();
+		std::string const text(logsys::detail::rt_text_size + 10, 'x');
+		logsys::log([&text](logsys::rtlog& log){ log << text; });
+
+		clog_capture capture;
+		EXPECT_EQ(logsys::flush_rtlog(), 1);
+		EXPECT_NE(capture.str().find(
+				std::string(logsys::detail::rt_text_size, 'x') + "...\n"),
+			std::string::npos);
+	}
+
+	TEST(rtlog, writer_thread){
+		clog_capture capture;
+		logsys::start_rtlog_writer(std::chrono::milliseconds(1));
+
+		std::thread([]{
+				logsys::prepare_rt_thread();
+				logsys::log([](logsys::rtlog& log){ log << "written"; });
+			}).join();
+
+		logsys::stop_rtlog_writer();
+		EXPECT_NE(capture.str().find(") written\n"), std::string::npos);
+		EXPECT_EQ(logsys::flush_rtlog(), 0);
+	}
+
+
+	/// \brief A non blocking pipe
+	struct pipe_capture{
+		pipe_capture(){
+			EXPECT_EQ(::pipe2(fds, O_NONBLOCK), 0);
+		}
+
+		~pipe_capture(){
+			::close(fds[0]);
+			::close(fds[1]);
+		}
+
+		int fd()const noexcept{
+			return fds[1];
+		}
+
+		std::string str(){
+			std::string result;
+			char buffer[256];
+			ssize_t count;
+			while((count = ::read(fds[0], buffer, sizeof(buffer))) > 0){
+				result.append(buffer, static_cast< std::size_t >(count));
+			}
+			return result;
+		}
+
+		int fds[2];
+	};
+
+	/// \brief Target of the signal handlers
+	int signal_fd = -1;
+
+	TEST(rtlog, signal_log){
+		pipe_capture pipe;
+		signal_fd = pipe.fd();
+
+		auto const old = std::signal(SIGUSR1, [](int){
+				logsys::signal_log_to(signal_fd, "signal ", SIGUSR1, " ",
+					2.5, " ", true, " ", std::string_view("sv"));
+			});
+
+		rt_section section;
+		std::raise(SIGUSR1);
+		section.disarm();
+		std::signal(SIGUSR1, old);
+
+		EXPECT_EQ(section.allocations, 0);
+		EXPECT_EQ(section.deallocations, 0);
+		EXPECT_EQ(section.mutex_locks, 0);
+		EXPECT_EQ(section.system_calls, 1); // the write(2)
+
+		auto const text = pipe.str();
+		EXPECT_EQ(text.substr(0, 7), "------ ");
+		EXPECT_EQ(text.size(), 7 + 27 + 20 + 22);
+		EXPECT_NE(text.find(" ( signal handler ) signal 10 2.5 true sv\n"),
+			std::string::npos) << text;
+
+		logsys::signal_log_to(pipe.fd(),
+			std::string(logsys::detail::signal_text_size + 10, 'x'));
+		EXPECT_NE(pipe.str().find(
+				std::string(logsys::detail::signal_text_size, 'x') + "...\n"),
+			std::string::npos);
+	}
+
+	TEST(rtlog, flush_from_signal){
+		logsys::prepare_rt_thread();
+		logsys::flush_rtlog();
+		auto const before = logsys::rtlog_statistics();
+
+		for(int i = 0; i < 3; ++i){
+			logsys::log([i](logsys::rtlog& log){ log << "pending " << i; },
+				[]{});
+		}
+
+		pipe_capture pipe;
+		signal_fd = pipe.fd();
+		auto const old = std::signal(SIGUSR1, [](int){
+				logsys::flush_rtlog_from_signal(signal_fd);
+			});
+
+		rt_section section;
+		std::raise(SIGUSR1);
+		section.disarm();
+		std::signal(SIGUSR1, old);
+
+		EXPECT_EQ(section.allocations, 0);
+		EXPECT_EQ(section.deallocations, 0);
+		EXPECT_EQ(section.mutex_locks, 0);
+		EXPECT_EQ(section.system_calls, 3);
+
+		auto const text = pipe.str();
+		EXPECT_EQ(count_lines(text), 3);
+		EXPECT_NE(text.find("ms ) pending 2\n"), std::string::npos) << text;
+
+		EXPECT_EQ(logsys::flush_rtlog(), 0);
+		auto const after = logsys::rtlog_statistics();
+		EXPECT_EQ(after.written - before.written, 3);
+	}
+
+
+	TEST(rtlog, fork){
+		logsys::prepare_rt_thread();
+		logsys::flush_rtlog();
+		logsys::start_rtlog_writer(std::chrono::milliseconds(1000));
+
+		logsys::log([](logsys::rtlog& log){ log << "before fork"; });
+
+		clog_capture capture;
+		auto const pid = ::fork();
+		if(pid == 0){
+			int status = 0;
+			if(logsys::flush_rtlog() != 0) status |= 1;
+			logsys::log([](logsys::rtlog& log){ log << "in child"; });
+			if(logsys::flush_rtlog() != 1) status |= 2;
+			logsys::stop_rtlog_writer();
+			::_exit(status);
+		}
+
+		ASSERT_GT(pid, 0);
+		int status = 0;
+		ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+		EXPECT_TRUE(WIFEXITED(status));
+		EXPECT_EQ(WEXITSTATUS(status), 0);
+
+		logsys::stop_rtlog_writer();
+		auto const text = capture.str();
+		EXPECT_EQ(count_lines(text), 1);
+		EXPECT_NE(text.find(") before fork\n"), std::string::npos) << text;
+	}
+
+
+}
@@ -0,0 +1,119 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/sink.hpp>
+#include <logsys/stdlogb.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+
+namespace{
+
+
+	/// \brief Replace the global sinks while in scope
+	struct sinks_guard{
+		sinks_guard(std::vector< std::shared_ptr< logsys::sink > > list)
+			: old_(logsys::sinks().sinks())
+		{
+			logsys::clear_sinks();
+			for(auto& s: list) logsys::add_sink(std::move(s));
+		}
+
+		~sinks_guard(){
+			logsys::clear_sinks();
+			for(auto const& s: old_) logsys::add_sink(s);
+		}
+
+		std::vector< std::shared_ptr< logsys::sink > > old_;
+	};
+
+
+	struct failure_sink: logsys::ring_sink{
+		using ring_sink::ring_sink;
+
+		bool accept(logsys::record_info const& info)const noexcept override{
+			return info.failed();
+		}
+	};
+
+
+	TEST(sink, render_once){
+		auto a = std::make_shared< logsys::ring_sink >(4);
+		auto b = std::make_shared< logsys::ring_sink >(4);
+		logsys::sink_list list({a, b});
+
+		std::size_t render_count = 0;
+		list.dispatch(logsys::record_info{}, [&render_count]{
+				++render_count;
+				return std::string("line");
+			});
+
+		EXPECT_EQ(render_count, 1);
+		ASSERT_EQ(a->lines().size(), 1);
+		ASSERT_EQ(b->lines().size(), 1);
+		EXPECT_EQ(a->lines()[0], b->lines()[0]);
+		EXPECT_EQ(*a->lines()[0], "line");
+	}
+
+	TEST(sink, filter_before_render){
+		auto failures = std::make_shared< failure_sink >(4);
+		auto counter = std::make_shared< logsys::counter_sink >();
+		logsys::sink_list list({failures, counter});
+
+		std::size_t render_count = 0;
+		list.dispatch(logsys::record_info{}, [&render_count]{
+				++render_count;
+				return std::string("line");
+			});
+
+		EXPECT_EQ(render_count, 0);
+		EXPECT_EQ(failures->lines().size(), 0);
+		EXPECT_EQ(counter->records(), 1);
+		EXPECT_EQ(counter->failures(), 0);
+	}
+
+	TEST(sink, ring_capacity){
+		logsys::ring_sink ring(2);
+		for(auto text: {"a", "b", "c"}){
+			ring.write(logsys::record_info{},
+				std::make_shared< std::string const >(text));
+		}
+
+		auto lines = ring.lines();
+		ASSERT_EQ(lines.size(), 2);
+		EXPECT_EQ(*lines[0], "b");
+		EXPECT_EQ(*lines[1], "c");
+	}
+
+	TEST(sink, stdlogb_fan_out){
+		auto ring = std::make_shared< logsys::ring_sink >(4);
+		auto failures = std::make_shared< failure_sink >(4);
+		auto counter = std::make_shared< logsys::counter_sink >();
+		sinks_guard guard({ring, failures, counter});
+
+		logsys::log([](logsys::stdlogb& log){ log << "first"; });
+		logsys::exception_catching_log(
+			[](logsys::stdlogb& log){ log << "second"; },
+			[]{ throw std::runtime_error("error"); });
+
+		auto lines = ring.get()->lines();
+		ASSERT_EQ(lines.size(), 2);
+		EXPECT_NE(lines[0]->find("first"), std::string::npos);
+		EXPECT_NE(lines[1]->find("second"), std::string::npos);
+
+		auto failed = failures->lines();
+		ASSERT_EQ(failed.size(), 1);
+		EXPECT_EQ(failed[0], lines[1]);
+
+		EXPECT_EQ(counter->records(), 2);
+		EXPECT_EQ(counter->failures(), 1);
+	}
+
+
+}
@@ -0,0 +1,151 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/stdlogb_buffered.hpp>
+#include <logsys/config.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <stdexcept>
+
+
+namespace{
+
+
+	/// \brief Counts the virtual calls
+	struct call_counter: logsys::stdlog_base{
+		void body_finished()noexcept override{ ++calls().other; }
+
+		void set_body_exception(std::exception_ptr, bool)noexcept override{
+			++calls().other;
+		}
+
+		void set_log_exception(std::exception_ptr)noexcept override{
+			++calls().other;
+		}
+
+		void set_level(logsys::level)noexcept override{ ++calls().other; }
+
+		void exec()const noexcept override{ ++calls().other; }
+
+		void exec_record(logsys::log_record const& record)noexcept override{
+			++calls().exec_record;
+			calls().info = record.info;
+			calls().message = std::string(record.message);
+			calls().body_exception = static_cast< bool >(record.body_exception);
+		}
+
+		std::ostream& os()noexcept override{
+			++calls().other;
+			return os_;
+		}
+
+		struct counts{
+			std::size_t exec_record = 0;
+			std::size_t other = 0;
+			logsys::record_info info{};
+			std::string message;
+			bool body_exception = false;
+		};
+
+		static counts& calls(){
+			static counts result;
+			return result;
+		}
+
+		std::ostringstream os_;
+	};
+
+	/// \brief Only implements the stream and exec()
+	struct replayed: logsys::stdlog_base{
+		void exec()const noexcept override{ text() = os_.str(); }
+
+		std::ostream& os()noexcept override{ return os_; }
+
+		static std::string& text(){
+			static std::string result;
+			return result;
+		}
+
+		std::ostringstream os_;
+	};
+
+
+	struct factory_guard{
+		factory_guard(std::unique_ptr< logsys::stdlog_base >(*f)()noexcept)
+			: old(*logsys::config())
+		{
+			logsys::modify_config([f](logsys::configuration& c){
+					c.factory = f;
+				});
+		}
+
+		~factory_guard(){
+			logsys::set_config(old);
+		}
+
+		logsys::configuration old;
+	};
+
+
+	TEST(stdlogb_buffered, one_virtual_call){
+		factory_guard guard([]()noexcept->std::unique_ptr< logsys::stdlog_base >{
+				return std::make_unique< call_counter >();
+			});
+		call_counter::calls() = {};
+
+		EXPECT_THROW(logsys::log([](logsys::stdlogb_buffered& log){
+				log << logsys::level::warning << "a " << 1 << " " << 2.5;
+			}, []{ throw std::runtime_error("error"); }), std::runtime_error);
+
+		auto const& calls = call_counter::calls();
+		EXPECT_EQ(calls.exec_record, 1);
+		EXPECT_EQ(calls.other, 0);
+		EXPECT_EQ(calls.message, "a 1 2.5");
+		EXPECT_EQ(calls.info.level, logsys::level::warning);
+		EXPECT_EQ(calls.info.body, logsys::body_state::failed_by_exception);
+		EXPECT_TRUE(calls.body_exception);
+		EXPECT_LE(calls.info.start, calls.info.end);
+	}
+
+	TEST(stdlogb_buffered, replay){
+		factory_guard guard([]()noexcept->std::unique_ptr< logsys::stdlog_base >{
+				return std::make_unique< replayed >();
+			});
+		replayed::text().clear();
+
+		logsys::log([](logsys::stdlogb_buffered& log){
+				log << "value " << std::hex << 255;
+			});
+
+		EXPECT_EQ(replayed::text(), "value ff");
+	}
+
+	TEST(stdlogb_buffered, stdlogd){
+		auto const old = *logsys::config();
+		auto ring = std::make_shared< logsys::ring_sink >(10);
+		logsys::modify_config([&ring](logsys::configuration& c){
+				c.sinks = logsys::sink_list({ring});
+			});
+
+		logsys::exception_catching_log([](logsys::stdlogb_buffered& log){
+				log << "buffered";
+			}, []{ throw std::runtime_error("error"); });
+
+		logsys::set_config(old);
+
+		auto const lines = ring->lines();
+		ASSERT_EQ(lines.size(), 1);
+		EXPECT_NE(lines[0]->find("ms ) buffered (BODY EXCEPTION CATCHED: "),
+			std::string::npos);
+	}
+
+
+}
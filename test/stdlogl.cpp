@@ -0,0 +1,67 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/stdlogl.hpp>
+
+#include "gtest/gtest.h"
+
+#include <limits>
+
+
+namespace{
+
+
+	/// \brief Message part of a log line
+	std::string text_of(std::string const& line){
+		auto const pos = line.find(" ) ");
+		return pos == std::string::npos ? line : line.substr(pos + 3);
+	}
+
+	template < typename ... T >
+	void expect_same_text(T const& ... values){
+		logsys::stdlog log;
+		logsys::stdlogl lazy;
+		(log << ... << values);
+		(lazy << ... << values);
+		EXPECT_EQ(text_of(lazy.make_log_line()), text_of(log.make_log_line()));
+	}
+
+
+	TEST(stdlogl, same_text_as_stdlog){
+		std::string const text = "string";
+		std::string_view const view = "view";
+		char const* const null = nullptr;
+
+		expect_same_text("text ", text, ' ', view, null);
+		expect_same_text('a', static_cast< signed char >(-5),
+			static_cast< unsigned char >(200));
+		expect_same_text(true, ' ', false);
+		expect_same_text(0, ' ', -17, ' ', 42u, ' ',
+			std::numeric_limits< long long >::min(), ' ',
+			std::numeric_limits< unsigned long long >::max());
+		expect_same_text("a ", 1.5, " b ", 7, " c ", true);
+		expect_same_text(std::hex, 255, ' ', 'x');
+	}
+
+	TEST(stdlogl, message){
+		logsys::stdlogl log;
+		log << "value " << 42;
+		EXPECT_EQ(text_of(log.make_log_line()), "value 42\n");
+		log << " " << 0.5 << " " << 7;
+		EXPECT_EQ(text_of(log.make_log_line()), "value 42 0.5 7\n");
+	}
+
+	TEST(stdlogl, level){
+		logsys::stdlogl log;
+		log << logsys::level::error << "x";
+		EXPECT_EQ(log.info().level, logsys::level::error);
+		EXPECT_EQ(text_of(log.make_log_line()), "x\n");
+	}
+
+
+}
@@ -0,0 +1,67 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2018 Benjamin Buch
+//
+// https://github.com/bebuch/logsys
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+//-----------------------------------------------------------------------------
+#include <logsys/stdlogt.hpp>
+#include <logsys/log.hpp>
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <vector>
+
+
+namespace{
+
+
+	struct vector_tag{};
+
+	std::vector< std::pair< logsys::record_info, std::string > > lines;
+
+
+}
+
+
+namespace logsys{
+
+
+	template <>
+	struct sink_binding< vector_tag >{
+		static void write(record_info const& info, std::string const& line){
+			lines.emplace_back(info, line);
+		}
+	};
+
+
+}
+
+
+namespace{
+
+
+	TEST(stdlogt, sink_binding){
+		lines.clear();
+
+		logsys::log([](logsys::stdlogt< vector_tag >& log){
+				log << logsys::level::warning << "bound";
+			});
+
+		EXPECT_FALSE(logsys::exception_catching_log(
+			[](logsys::stdlogt< vector_tag >& log){
+				log << "failed";
+			}, []{ throw std::runtime_error("error"); }));
+
+		ASSERT_EQ(lines.size(), 2);
+		EXPECT_EQ(lines[0].first.level, logsys::level::warning);
+		EXPECT_NE(lines[0].second.find("bound\n"), std::string::npos);
+		EXPECT_EQ(lines[1].first.body, logsys::body_state::catched_exception);
+		EXPECT_NE(lines[1].second.find("ms ) failed (BODY EXCEPTION CATCHED: "),
+			std::string::npos) << lines[1].second;
+	}
+
+
+}